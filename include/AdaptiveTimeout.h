@@ -0,0 +1,65 @@
+#ifndef ADAPTIVE_TIMEOUT_H
+#define ADAPTIVE_TIMEOUT_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Latency buckets per phase, each sqrt(2) wider than the last (128 ms to
+// 23 s), and the samples kept: beyond LATENCY_WINDOW all counts are halved,
+// so old wakes fade out
+#define LATENCY_BUCKETS 16
+#define LATENCY_WINDOW 64
+// While a phase keeps timing out, every TIMEOUT_PROBE_EVERY-th wait (the
+// first one included) gets the ceiling, so a slower network is relearned
+#define TIMEOUT_PROBE_EVERY 4
+
+// Network waits with a learned timeout
+enum TimeoutPhase : uint8_t {
+    TIMEOUT_ASSOCIATE,       // cached AP, static IP or DHCP
+    TIMEOUT_ASSOCIATE_SCAN,  // AP found by a scan, with DHCP
+    TIMEOUT_NTP,             // from the start of the background sync
+    TIMEOUT_HTTP,            // request sent to response headers
+    TIMEOUT_TLS_FULL,        // handshake with certificate and key exchange
+    TIMEOUT_TLS_RESUMED,     // handshake resuming the stored session
+    TIMEOUT_COUNT
+};
+
+// Latency histogram of one phase
+struct __attribute__((packed)) LatencyHistory {
+    uint8_t counts[LATENCY_BUCKETS];
+};
+
+// Timeouts from the latencies of previous wakes instead of fixed worst
+// cases, so a wait on a dead AP or a hanging server ends soon after the
+// network would normally have answered. Each phase keeps a histogram in RTC
+// memory; its timeout is the 95th percentile times TIMEOUT_MARGIN_PERCENT,
+// between a floor and the old fixed value as the ceiling.
+class AdaptiveTimeout {
+public:
+    // Timeout (ms) for the next wait of `phase`: the ceiling until
+    // TIMEOUT_MIN_SAMPLES latencies are in, and for probes after a timeout
+    static unsigned long get(TimeoutPhase phase);
+    // A wait that finished after `ms`. One slower than the learned timeout
+    // means the network changed: the phase starts learning again.
+    static void record(TimeoutPhase phase, unsigned long ms);
+    // A wait that ran into its timeout (no latency sample)
+    static void recordTimeout(TimeoutPhase phase);
+    // Forgets all phases, e.g. on a different access point
+    static void relearn();
+
+    // 95th percentile estimate (upper bucket edge), 0 without enough samples
+    static unsigned long percentileMs(TimeoutPhase phase);
+    static uint8_t samples(TimeoutPhase phase);
+    static unsigned long ceilingMs(TimeoutPhase phase);
+    static const char* phaseName(TimeoutPhase phase);
+
+private:
+    static unsigned long learnedMs(TimeoutPhase phase);
+    static uint8_t bucket(unsigned long ms);
+
+    // RTC memory variables
+    static RTC_DATA_ATTR LatencyHistory rtc_latency[TIMEOUT_COUNT];
+    static RTC_DATA_ATTR uint8_t rtc_timeouts[TIMEOUT_COUNT];
+};
+
+#endif // ADAPTIVE_TIMEOUT_H
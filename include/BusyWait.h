@@ -0,0 +1,48 @@
+#ifndef BUSY_WAIT_H
+#define BUSY_WAIT_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Longest light sleep per callback; GxEPD2 checks its busy timeout between
+// two of them
+#define BUSY_WAKE_INTERVAL_MS 500
+// ESP32-C3 supply current (uA) while idling awake in delay(1) and in light
+// sleep, for the charge estimate of the report (the panel's own is the same)
+#define BUSY_POLL_CURRENT_UA 22000
+#define BUSY_SLEEP_CURRENT_UA 200
+
+// One section of BUSY waits
+struct BusyStats {
+    uint32_t busyMs;   // time spent waiting for the panel
+    uint32_t sleepMs;  // of that, in light sleep
+    uint16_t sleeps;
+};
+
+// Waits on the panel's BUSY line in light sleep instead of polling it.
+// GxEPD2 calls callback() (display.epd2.setBusyCallback) in its busy loop;
+// between begin() and end() it sleeps until BUSY changes level or the timer
+// slice runs out. Outside a section, and while WiFi is on, it polls like
+// GxEPD2 does without a callback.
+class BusyWait {
+public:
+    static void begin(bool lightSleep = BUSY_LIGHT_SLEEP);
+    // Logs the section's wait time and estimated charge against polling
+    static void end(const char* label);
+    static void callback(const void* context);
+    // Arms the deep-sleep timer wake; BUSY waits borrow the timer for their
+    // slices and re-arm it with this interval afterwards
+    static void setSleepTimer(uint64_t us);
+    static const BusyStats& stats();
+    // Charge (uA*ms) the section took, and would have taken polling
+    static uint64_t chargeUaMs();
+    static uint64_t pollingChargeUaMs();
+
+private:
+    static bool active;
+    static bool lightSleep;
+    static BusyStats current;
+    static uint64_t sleepTimerUs;
+};
+
+#endif // BUSY_WAIT_H
@@ -0,0 +1,49 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Network phases of a wake, checked against its time budget
+enum BreakerPhase : uint8_t {
+    BREAKER_WIFI,
+    BREAKER_NTP,
+    BREAKER_HTTP
+};
+
+// Limits the energy spent while the AP or API is down: failed wakes back off
+// exponentially and every wake has an overall time budget for its network
+// phases. WiFi and HTTP are what a wake is for, so their breakers derive
+// from the failed-wake count: open after BREAKER_FAILURE_LIMIT failed wakes,
+// with every backed-off wake as the probe that closes them. NTP, which a
+// wake can do without, has a counter of its own: after consecutive failures
+// it is only probed every BREAKER_PROBE_EVERY wakes.
+class CircuitBreaker {
+public:
+    static void beginWake();
+    // Enough of the wake budget left for the phase (and for NTP, the breaker
+    // is closed or this wake probes it)
+    static bool allow(BreakerPhase phase);
+    static bool isOpen(BreakerPhase phase);
+    static void recordNtp(bool synced);
+    static void recordWake(bool fetched);
+    static unsigned long remainingMs();
+    static unsigned long limitTimeout(unsigned long timeoutMs);
+    static uint32_t backoffSeconds(uint32_t baseSeconds);
+    static uint16_t failedWakes();
+    // The outage has lasted OFFLINE_REDRAW_AFTER failed wakes, worth a
+    // display refresh to show it
+    static bool showOffline();
+
+private:
+    static const char* phaseName(BreakerPhase phase);
+
+    // RTC memory variables
+    static RTC_DATA_ATTR uint8_t rtc_ntpFailures;
+    static RTC_DATA_ATTR uint8_t rtc_ntpSkipped;
+    static RTC_DATA_ATTR uint16_t rtc_failedWakes;
+
+    static unsigned long wakeStartMs;
+};
+
+#endif // CIRCUIT_BREAKER_H
@@ -0,0 +1,10 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+// CRC-32 (IEEE, same as zlib.crc32 in the tools), continued from crc (0 to
+// start). Checks the RTC records and the firmware images.
+uint32_t crc32(uint32_t crc, const uint8_t* bytes, size_t size);
+
+#endif // CRC32_H
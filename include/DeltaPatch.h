@@ -0,0 +1,107 @@
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include <Arduino.h>
+#include "Crc32.h"
+
+// Patch format written by tools/make_delta.py (integers little-endian):
+//
+//   header  "GTD1", u32 oldSize, u32 oldCrc, u32 newSize, u32 newCrc
+//   'C'     u32 source, u32 length, u16 edits, then per edit:
+//             u16 skip, u8 count, count bytes
+//           copies length bytes of the old image from source; each edit
+//           keeps skip bytes (counted from the end of the previous edit),
+//           then replaces the next count bytes
+//   'I'     u32 length, length bytes: new bytes inserted as they are
+//   'E'     end of the patch
+//
+// Moved code mostly differs from the old image in a few bytes (addresses),
+// so a copy with edits stays small without compressing anything.
+#define DELTA_MAGIC "GTD1"
+#define DELTA_HEADER_SIZE 20
+#define DELTA_OP_COPY 'C'
+#define DELTA_OP_INSERT 'I'
+#define DELTA_OP_END 'E'
+
+// Old image bytes read and new image bytes written per call
+#define DELTA_BUFFER_SIZE 256
+
+// Applies a patch while it streams in: the patch is fed in chunks of any
+// size, the old image is read back through a callback and the new image is
+// written out in order, so neither image is ever held in RAM. The base
+// image is checked against the header's CRC before anything is written and
+// the new image is checked once the patch ends. No heap is used.
+class DeltaPatch {
+public:
+    typedef bool (*ReadOld)(void* context, uint32_t offset, uint8_t* buffer, size_t size);
+    typedef bool (*WriteNew)(void* context, const uint8_t* bytes, size_t size);
+
+    enum Result : uint8_t {
+        PATCH_MORE,   // needs more patch bytes
+        PATCH_DONE,   // new image complete and verified
+        PATCH_ERROR   // see error()
+    };
+
+    DeltaPatch(ReadOld readOld, WriteNew writeNew, void* context);
+
+    Result feed(const uint8_t* bytes, size_t size);
+    const char* error() const { return failure; }
+    uint32_t newSize() const { return header.newSize; }
+    uint32_t written() const { return produced; }
+
+private:
+    enum State : uint8_t {
+        STATE_HEADER,
+        STATE_OP,
+        STATE_COPY,
+        STATE_EDIT,
+        STATE_EDIT_BYTES,
+        STATE_INSERT,
+        STATE_INSERT_BYTES,
+        STATE_DONE,
+        STATE_FAILED
+    };
+
+    struct Header {
+        uint32_t oldSize;
+        uint32_t oldCrc;
+        uint32_t newSize;
+        uint32_t newCrc;
+    };
+
+    bool collect(const uint8_t*& bytes, size_t& size, size_t needed);
+    bool step(const uint8_t*& bytes, size_t& size);
+    bool startCopy();
+    bool startEdit();
+    bool checkBase();
+    bool copyOld(uint32_t length);
+    bool emit(const uint8_t* bytes, size_t size);
+    bool flush();
+    bool finish();
+    bool fail(const char* reason);
+    static uint32_t readU32(const uint8_t* bytes);
+    static uint16_t readU16(const uint8_t* bytes);
+
+    ReadOld readOld;
+    WriteNew writeNew;
+    void* context;
+
+    State state;
+    const char* failure;
+    Header header;
+    // Fixed-size fields collected across feed() calls
+    uint8_t field[DELTA_HEADER_SIZE];
+    uint8_t fieldLength;
+
+    uint32_t source;       // next old image byte of the current copy
+    uint32_t copyLeft;     // bytes of the current copy not produced yet
+    uint16_t editsLeft;
+    uint32_t bytesLeft;    // edit or insert bytes still to come
+    uint32_t produced;
+    uint32_t crc;
+
+    uint8_t buffer[DELTA_BUFFER_SIZE];
+    size_t buffered;
+};
+
+#endif // DELTA_PATCH_H
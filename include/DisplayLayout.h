@@ -0,0 +1,112 @@
+#ifndef DISPLAY_LAYOUT_H
+#define DISPLAY_LAYOUT_H
+
+#include <stdint.h>
+
+// Character cells of the fonts on the goal screen (all monospaced), for the
+// fit checks below
+#define LARGE_FONT_ADVANCE 28   // FreeMonoBold24pt7b
+#define LARGE_FONT_ASCENT 30
+#define LABEL_FONT_ADVANCE 14   // FreeMonoBold12pt7b
+#define LABEL_FONT_ASCENT 15
+#define LABEL_FONT_DESCENT 5
+#define SMALL_FONT_ADVANCE 6    // built-in 5x7 font, drawn below the cursor
+#define SMALL_FONT_HEIGHT 8
+
+// Longest strings each element has to hold
+#define MAX_DAYS_CHARS 5        // "99999"
+#define MAX_PROGRESS_CHARS 6    // "100.0%"
+#define MAX_LABEL_CHARS 12      // "DAYS TO GOAL", or a goal name
+#define MAX_DATE_CHARS 17       // "Wed, Sep 30, 2026"
+#define MAX_FOOTER_CHARS 31     // "Last: 12/31 23:59 (offline) 8/8"
+
+// Pixel positions of the goal screen for one screen size (after rotation);
+// y values of text are baselines. Layouts are template arguments of
+// GoalRenderer and DisplayManager, so each build is compiled against the
+// constants of its own panel.
+struct DisplayLayout {
+    int16_t width;
+    int16_t height;
+    int16_t marginLeft;
+    int16_t marginRight;
+    int16_t marginTop;
+    int16_t marginBottom;
+    int16_t titleY;
+    int16_t mainTextY;
+    int16_t subtitleY;
+    int16_t detailY;
+    int16_t dividerX;
+    int16_t dividerEndY;
+    int16_t progressBarY;
+    int16_t progressBarHeight;
+    int16_t dateY;
+    int16_t errorIconSize;
+    int16_t errorIconMargin;
+    int16_t footerHeight;
+    int16_t trendY;
+    int16_t trendHeight;
+
+    // Right column (percentage, trend) starts a little past the divider
+    constexpr int16_t rightX() const { return dividerX + 20; }
+    constexpr int16_t footerY() const { return height - marginBottom; }
+
+    // Checks used by the static_asserts in DisplayManager.h
+    constexpr bool leftColumnFits() const {
+        return marginLeft + MAX_LABEL_CHARS * LABEL_FONT_ADVANCE <= dividerX &&
+               marginLeft + MAX_DAYS_CHARS * LARGE_FONT_ADVANCE <= dividerX;
+    }
+    constexpr bool rightColumnFits() const {
+        return rightX() + MAX_PROGRESS_CHARS * LARGE_FONT_ADVANCE <= width - marginRight &&
+               rightX() + MAX_LABEL_CHARS * LABEL_FONT_ADVANCE <= width;
+    }
+    constexpr bool rowsInOrder() const {
+        return titleY >= LABEL_FONT_ASCENT &&
+               mainTextY - LARGE_FONT_ASCENT >= titleY &&
+               subtitleY - LABEL_FONT_ASCENT >= mainTextY &&
+               detailY > subtitleY && detailY + SMALL_FONT_HEIGHT <= dividerEndY &&
+               trendY > subtitleY && trendY + trendHeight <= dividerEndY &&
+               dividerEndY < progressBarY &&
+               progressBarY + progressBarHeight + LABEL_FONT_ASCENT <= dateY &&
+               dateY + LABEL_FONT_DESCENT <= footerY() &&
+               footerY() + SMALL_FONT_HEIGHT <= height;
+    }
+    constexpr bool bottomFits() const {
+        return marginLeft + marginRight < width &&
+               MAX_DATE_CHARS * LABEL_FONT_ADVANCE <= width &&
+               marginLeft + MAX_FOOTER_CHARS * SMALL_FONT_ADVANCE <= width;
+    }
+    constexpr bool errorIconFits() const {
+        // The X reaches 5px from the center, the circle has to enclose it
+        return errorIconSize >= 5 && width - errorIconMargin + 5 + errorIconSize < width &&
+               marginTop + 5 - errorIconSize >= 0 &&
+               marginLeft + MAX_LABEL_CHARS * LABEL_FONT_ADVANCE < width - errorIconMargin + 5 - errorIconSize;
+    }
+};
+
+// 3.7" GDEY037T03 (240x416) in landscape
+inline constexpr DisplayLayout LAYOUT_416X240 = {
+    416, 240,               // width, height
+    10, 20, 10, 10,         // margins: left, right, top, bottom
+    25, 80, 105, 120,       // title, main text, subtitle, detail
+    200, 140,               // divider x, divider end y
+    150, 25,                // progress bar y, height
+    196,                    // target date
+    12, 25,                 // error icon size, margin
+    12,                     // footer height
+    114, 22,                // trend y, height
+};
+
+// 4.2" GDEY042T81 (400x300, landscape natively)
+inline constexpr DisplayLayout LAYOUT_400X300 = {
+    400, 300,
+    10, 20, 10, 10,
+    30, 100, 130, 148,
+    190, 180,
+    195, 30,
+    255,
+    12, 25,
+    12,
+    140, 34,
+};
+
+#endif // DISPLAY_LAYOUT_H
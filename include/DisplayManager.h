@@ -1,24 +1,68 @@
 #ifndef DISPLAY_MANAGER_H
 #define DISPLAY_MANAGER_H
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <GxEPD2_BW.h>
 #include <GxEPD2_3C.h>
-#include <Fonts/FreeMonoBold24pt7b.h>
-#include <Fonts/FreeMonoBold18pt7b.h>
-#include <Fonts/FreeMonoBold12pt7b.h>
 #include "GoalData.h"
+#include "GoalRenderer.h"
+#include "DisplayLayout.h"
+#include "WakeProfiler.h"
 #include "config.h"
 
-class DisplayManager {
+// Rows of the framebuffer: the whole panel if it fits DISPLAY_BUFFER_SIZE,
+// otherwise GxEPD2 draws the frame in pages of this height
+template <typename Panel>
+constexpr uint16_t pageHeight() {
+    return Panel::HEIGHT <= DISPLAY_BUFFER_SIZE / (Panel::WIDTH / 8)
+               ? Panel::HEIGHT
+               : DISPLAY_BUFFER_SIZE / (Panel::WIDTH / 8);
+}
+
+// Display state that doesn't depend on the panel (shared by all
+// PanelDisplay specializations)
+class DisplayState {
+protected:
+    // Last drawn frame (persists across deep sleep)
+    static RTC_DATA_ATTR FrameSignature rtc_lastFrame;
+    static RTC_DATA_ATTR uint8_t rtc_partialCount;
+    static RTC_DATA_ATTR bool rtc_hasFrame;
+
+    static bool initialized;
+    static SemaphoreHandle_t initDone;
+};
+
+// Goal screen on a GxEPD2 panel driver, drawn with a layout made for it.
+// Instantiated in DisplayManager.cpp for DISPLAY_PANEL and DISPLAY_LAYOUT.
+template <typename Panel, const DisplayLayout& Layout>
+class PanelDisplay : private DisplayState {
 public:
+    typedef GxEPD2_BW<Panel, pageHeight<Panel>()> Display;
+
+    static_assert(Layout.width == ((DISPLAY_ROTATION & 1) ? Panel::HEIGHT : Panel::WIDTH) &&
+                  Layout.height == ((DISPLAY_ROTATION & 1) ? Panel::WIDTH : Panel::HEIGHT),
+                  "DISPLAY_LAYOUT is not the size of DISPLAY_PANEL at DISPLAY_ROTATION");
+    static_assert(Layout.leftColumnFits(), "days or labels overlap the divider");
+    static_assert(Layout.rightColumnFits(), "percentage or labels run off the right edge");
+    static_assert(Layout.rowsInOrder(), "layout rows overlap or run off the bottom edge");
+    static_assert(Layout.bottomFits(), "target date or footer is wider than the panel");
+    static_assert(Layout.errorIconFits(), "error icon is off the panel or overlaps the title");
+
+    static void beginInit();
     static void init();
+    static bool needsRedraw(const GoalData& data);
     static void showGoalInfo(const GoalData& data);
     static void showError(const char* message);
     static void hibernate();
 
 private:
-    static void drawErrorIcon();
-    static GxEPD2_BW<GxEPD2_370_GDEY037T03, GxEPD2_370_GDEY037T03::HEIGHT>& getDisplay();
+    static void initTask(void* param);
+    static void powerUp();
+
+    static Display display;
 };
 
+typedef PanelDisplay<DISPLAY_PANEL, DISPLAY_LAYOUT> DisplayManager;
+
 #endif // DISPLAY_MANAGER_H
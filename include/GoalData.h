@@ -2,32 +2,88 @@
 #define GOAL_DATA_H
 
 #include <Arduino.h>
+#include <time.h>
+#include "config.h"
 
-// Data structure for goal tracking information
+// One day of progress history, for the trend sparkline
+struct __attribute__((packed)) TrendSample {
+    uint16_t day;            // days since 1970-01-01 (UTC)
+    uint16_t progressCenti;  // progress in hundredths of a percent
+};
+
+// Longest goal name kept (the title line fits 12 characters)
+#define GOAL_NAME_SIZE 13
+
+// Data structure for goal tracking information. Only fixed-size fields, so
+// it can be copied and kept without touching the heap; dates are formatted
+// when drawn.
 struct GoalData {
     int daysToGoal;
     float progressPercent;
-    String lastUpdateTime;
-    String targetDate;
     bool isValid;
     bool lastUpdateSuccess;
+    time_t dataTime = 0;    // data_timestamp of the API response, 0 if unknown
+    time_t targetTime = 0;  // when the goal is projected to be reached, 0 if unknown
+
+    // Goal name from a batched response (empty for a single goal) and the
+    // page it is shown on
+    char name[GOAL_NAME_SIZE] = "";
+    uint8_t page = 0;
+    uint8_t pageCount = 1;
+
+    // Progress of the last days, oldest first
+    TrendSample trend[TREND_HISTORY_DAYS];
+    uint8_t trendCount = 0;
+};
+
+// Display formats of the strings derived from the stored timestamps
+#define UPDATE_TIME_FORMAT "%m/%d %H:%M"     // e.g. "10/28 11:51"
+#define TARGET_DATE_FORMAT "%a, %b %d, %Y"   // e.g. "Mon, Oct 27, 2025"
+// Buffer size for either of them
+#define DATE_TEXT_SIZE 24
+
+// Layout of the RTC record; bump GOAL_RECORD_VERSION whenever it changes so
+// data from an older firmware is discarded instead of misread
+#define GOAL_RECORD_VERSION 3
+
+static_assert(GOAL_COUNT >= 1 && GOAL_COUNT <= 8, "GOAL_COUNT must be 1-8");
+
+struct __attribute__((packed)) GoalRecord {
+    uint8_t version;
+    uint8_t flags;
+    int32_t daysToGoal;
+    uint16_t progressCenti;
+    uint32_t dataEpoch;   // data_timestamp of the response
+    uint32_t fetchEpoch;  // when it was fetched (target date is counted from here)
+    uint8_t trendHead;
+    uint8_t trendCount;
+    TrendSample trend[TREND_HISTORY_DAYS];
+    char name[GOAL_NAME_SIZE];
+    uint32_t crc;
 };
 
-// RTC memory storage (persists across deep sleep)
+// RTC memory storage (persists across deep sleep), one record per goal
 class DataStorage {
 public:
-    static void save(const GoalData& data);
-    static bool load(GoalData& data);
+    static void save(const GoalData& data, uint8_t index = 0);
+    static bool load(GoalData& data, uint8_t index = 0);
     static bool hasData();
 
+    // Goals in the last response; pages rotate through them
+    static void setGoalCount(uint8_t count);
+    static uint8_t goalCount();
+    static uint8_t currentPage();
+    static uint8_t nextPage();
+
 private:
+    static bool isValid(const GoalRecord& record);
+    static void addTrendSample(GoalRecord& record, uint16_t day, uint16_t progressCenti);
+    static uint32_t checksum(const GoalRecord& record);
+
     // RTC memory variables
-    static RTC_DATA_ATTR int rtc_daysToGoal;
-    static RTC_DATA_ATTR float rtc_progressPercent;
-    static RTC_DATA_ATTR char rtc_lastUpdateTime[20];
-    static RTC_DATA_ATTR char rtc_targetDate[30];
-    static RTC_DATA_ATTR bool rtc_lastUpdateSuccess;
-    static RTC_DATA_ATTR bool rtc_hasData;
+    static RTC_DATA_ATTR GoalRecord rtc_records[GOAL_COUNT];
+    static RTC_DATA_ATTR uint8_t rtc_goalCount;
+    static RTC_DATA_ATTR uint8_t rtc_page;
 };
 
 #endif // GOAL_DATA_H
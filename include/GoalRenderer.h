@@ -0,0 +1,85 @@
+#ifndef GOAL_RENDERER_H
+#define GOAL_RENDERER_H
+
+#include <Adafruit_GFX.h>
+#include <Fonts/FreeMonoBold24pt7b.h>
+#include <Fonts/FreeMonoBold18pt7b.h>
+#include <Fonts/FreeMonoBold12pt7b.h>
+#include "GoalData.h"
+#include "DisplayLayout.h"
+
+// Same values as GxEPD2, so the renderer doesn't depend on the panel driver
+#ifndef GxEPD_BLACK
+#define GxEPD_BLACK 0x0000
+#endif
+#ifndef GxEPD_WHITE
+#define GxEPD_WHITE 0xFFFF
+#endif
+
+struct PrerenderedBitmap;
+
+// Compact summary of the values drawn in the last frame (kept in RTC memory)
+struct FrameSignature {
+    int32_t daysToGoal;
+    int16_t progressTenths;
+    int16_t barFill;
+    uint32_t targetDateHash;
+    uint32_t footerHash;
+    uint32_t trendHash;
+    uint32_t titleHash;
+    bool errorIcon;
+};
+
+// Draws the goal screen on any Adafruit GFX surface (the e-ink panel on the
+// device, an offscreen canvas in the native build). Layout dependent methods
+// are templates on the DisplayLayout, instantiated in GoalRenderer.cpp.
+class GoalRenderer {
+public:
+    // Screen regions that change between updates
+    enum Region : uint8_t {
+        REGION_DAYS = 1 << 0,
+        REGION_PROGRESS = 1 << 1,
+        REGION_BAR = 1 << 2,
+        REGION_DATE = 1 << 3,
+        REGION_FOOTER = 1 << 4,
+        REGION_ERROR_ICON = 1 << 5,
+        REGION_TREND = 1 << 6,
+        REGION_TITLE = 1 << 7
+    };
+
+    struct Rect {
+        int16_t x, y, w, h;
+    };
+
+    template <const DisplayLayout& L>
+    static void draw(Adafruit_GFX& gfx, const GoalData& data);
+    template <const DisplayLayout& L>
+    static FrameSignature makeSignature(const GoalData& data);
+    static uint8_t dirtyRegions(const FrameSignature& previous, const FrameSignature& current);
+    template <const DisplayLayout& L>
+    static Rect regionRect(Region region);
+    template <const DisplayLayout& L>
+    static Rect dirtyBounds(uint8_t dirty);
+
+    // Draw the labels and large numbers from the build-time bitmaps
+    // (default) or from the fonts; both give the same pixels
+    static void setPrerendered(bool enabled);
+
+private:
+    static void drawLabel(Adafruit_GFX& gfx, int16_t x, int16_t y, const char* text,
+                          const PrerenderedBitmap* bitmap);
+    static void drawLargeText(Adafruit_GFX& gfx, int16_t x, int16_t y, const char* text);
+    static void blit(Adafruit_GFX& gfx, int16_t x, int16_t y, const PrerenderedBitmap& bitmap);
+    template <const DisplayLayout& L>
+    static void drawErrorIcon(Adafruit_GFX& gfx);
+    template <const DisplayLayout& L>
+    static void drawTrend(Adafruit_GFX& gfx, const GoalData& data);
+    template <const DisplayLayout& L>
+    static int progressFillWidth(float progressPercent);
+    static void formatFooter(const GoalData& data, char* buffer, size_t size);
+    static uint32_t hashBytes(const void* bytes, size_t size);
+
+    static bool usePrerendered;
+};
+
+#endif // GOAL_RENDERER_H
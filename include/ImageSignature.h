@@ -0,0 +1,24 @@
+#ifndef IMAGE_SIGNATURE_H
+#define IMAGE_SIGNATURE_H
+
+#include <Arduino.h>
+
+// Longest signature accepted: a DER encoded ECDSA P-256 signature (at most
+// 72 bytes) as hex digits, with the terminator
+#define IMAGE_SIGNATURE_SIZE 145
+
+// Checks a firmware image against an ECDSA P-256 signature of its SHA-256,
+// made with the private key of OTA_PUBLIC_KEY (tools/make_delta.py --sign).
+// The image is hashed while it is written, so it is never held in RAM. One
+// image at a time, the hash state is static. Device builds use mbedTLS;
+// src/native/HostImageSignature.cpp stands in for it on the host.
+class ImageSignature {
+public:
+    static void begin();
+    static void update(const uint8_t* bytes, size_t size);
+    // True if `signature` (hex) signs the bytes hashed since begin() with
+    // the key in `publicKey` (PEM)
+    static bool verify(const char* signature, const char* publicKey);
+};
+
+#endif // IMAGE_SIGNATURE_H
@@ -0,0 +1,124 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include "config.h"
+
+// Log levels, most important first
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Longest Serial line (longer messages are cut), formatted on the stack
+#define LOG_LINE_SIZE 160
+// Numeric arguments kept per RTC record
+#define LOG_RECORD_VALUES 2
+// Longest X-Device-Log header value
+#define LOG_UPLOAD_SIZE 512
+
+// printf-style logging. A message goes to Serial up to LOG_LEVEL and into
+// the RTC ring up to LOG_RTC_LEVEL. Above both levels a call compiles to
+// nothing (its arguments aren't evaluated, only checked). No heap is used.
+#define LOG_ENABLED(level) (LOG_LEVEL >= (level) || LOG_RTC_LEVEL >= (level))
+#define LOG_SKIP(...) do { if (false) Log::checkFormat(__VA_ARGS__); } while (0)
+#define LOG_AT(level, ...) do { LOG_SKIP(__VA_ARGS__); Log::write<level>(__VA_ARGS__); } while (0)
+
+#if LOG_ENABLED(LOG_LEVEL_ERROR)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_SKIP(__VA_ARGS__)
+#endif
+#if LOG_ENABLED(LOG_LEVEL_WARN)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_SKIP(__VA_ARGS__)
+#endif
+#if LOG_ENABLED(LOG_LEVEL_INFO)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_SKIP(__VA_ARGS__)
+#endif
+#if LOG_ENABLED(LOG_LEVEL_DEBUG)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_SKIP(__VA_ARGS__)
+#endif
+
+// One message in the RTC ring: the format string stays in flash, numeric
+// arguments are kept as 32-bit values (strings as "?"). RTC data is reset
+// on every boot that isn't a deep-sleep wake (flashing, OTA), so the format
+// pointer never outlives the firmware it points into.
+struct __attribute__((packed)) LogRecord {
+    uint32_t time;
+    const char* format;
+    uint32_t values[LOG_RECORD_VALUES];
+    uint8_t level;
+};
+
+class Log {
+public:
+    // Starts Serial if anything is logged to it; debug builds wait for the
+    // USB console
+    static void begin();
+    static void flush();
+
+    template <uint8_t Level, typename... Args>
+    static void write(const char* format, Args... args) {
+        if constexpr (Level <= LOG_LEVEL) {
+            if constexpr (sizeof...(Args) == 0) {
+                Serial.println(format);
+            } else {
+                char line[LOG_LINE_SIZE];
+                snprintf(line, sizeof(line), format, args...);
+                Serial.println(line);
+            }
+        }
+        if constexpr (Level <= LOG_RTC_LEVEL && LOG_RTC_ENTRIES > 0) {
+            uint32_t values[LOG_RECORD_VALUES] = {0};
+            uint8_t count = 0;
+            ((count < LOG_RECORD_VALUES ? (void)(values[count++] = pack(args)) : (void)0), ...);
+            record(Level, format, values);
+        }
+    }
+
+    // Lets the compiler check the arguments against the format
+    __attribute__((format(printf, 1, 2))) static void checkFormat(const char* format, ...) {}
+
+    // RTC records not uploaded yet, like WakeProfiler's
+    static bool hasPending();
+    static size_t formatPending(char* buffer, size_t size);
+    static void clearPending();
+    // All records as text lines (debug console)
+    static void dump(Print& out);
+
+private:
+    template <typename T>
+    static uint32_t pack(T value) {
+        if constexpr (std::is_floating_point<T>::value) {
+            float f = (float)value;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+            return (uint32_t)value;
+        } else {
+            return 0;  // strings and pointers don't outlive the wake
+        }
+    }
+
+    static void record(uint8_t level, const char* format, const uint32_t* values);
+    static size_t formatRecord(const LogRecord& record, char* buffer, size_t size);
+
+    // RTC memory ring buffer of records
+    static RTC_DATA_ATTR LogRecord rtc_records[LOG_RTC_ENTRIES > 0 ? LOG_RTC_ENTRIES : 1];
+    static RTC_DATA_ATTR uint8_t rtc_head;
+    static RTC_DATA_ATTR uint8_t rtc_count;
+    static RTC_DATA_ATTR uint8_t rtc_pending;
+};
+
+#endif // LOG_H
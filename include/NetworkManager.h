@@ -8,16 +8,55 @@
 #include <time.h>
 #include <esp_wifi.h>
 #include "GoalData.h"
+#include "AdaptiveTimeout.h"
+#include "CircuitBreaker.h"
+#include "OtaUpdater.h"
+#include "TimeKeeper.h"
+#include "TlsClient.h"
+#include "WakeProfiler.h"
+#include "WakeScheduler.h"
 #include "config.h"
 
 class NetworkManager {
 public:
     static bool connectWiFi();
-    static void syncTime();
-    static String formatTimestamp(const char* isoTimestamp);
-    static String getTargetDate(int daysToGoal);
+    static void disconnect();
+    // Fetches up to maxGoals goals with one request; count is set to the
+    // number received
+    static bool fetchGoals(GoalData* goals, uint8_t maxGoals, uint8_t& count);
     static bool fetchGoalData(GoalData& data);
-    static bool fetchMockData(GoalData& data);
+    static bool fetchMockData(GoalData* goals, uint8_t maxGoals, uint8_t& count);
+
+private:
+    static void buildFilter(JsonDocument& filter);
+    static uint8_t extractGoals(JsonDocument& doc, GoalData* goals, uint8_t maxGoals);
+    static void extractGoalData(JsonVariantConst goal, GoalData& data);
+    static time_t projectTarget(int daysToGoal);
+    static void storeValidators(HTTPClient& http);
+    static void readMaxAge(HTTPClient& http);
+    static bool connectCached();
+    static bool connectByScan(int32_t channel);
+    static bool waitForConnection(TimeoutPhase phase);
+    static void saveConnection();
+    // A DHCP lease was just obtained; the one in RTC memory is young enough
+    // to reuse as a static IP
+    static void startLease();
+    static bool leaseFresh();
+    static void logConnectTime(const char* path, unsigned long startMs);
+
+    // Last good connection (persists across deep sleep)
+    static RTC_DATA_ATTR uint8_t rtc_bssid[6];
+    static RTC_DATA_ATTR int32_t rtc_channel;
+    static RTC_DATA_ATTR uint32_t rtc_localIP;
+    static RTC_DATA_ATTR uint32_t rtc_gateway;
+    static RTC_DATA_ATTR uint32_t rtc_subnet;
+    static RTC_DATA_ATTR uint32_t rtc_dns;
+    static RTC_DATA_ATTR time_t rtc_leaseEpoch;  // DHCP lease obtained, 0 if unknown
+    static RTC_DATA_ATTR bool rtc_hasConnection;
+
+    // Cache validators of the last successful response (persist across deep sleep)
+    static RTC_DATA_ATTR char rtc_etag[64];
+    static RTC_DATA_ATTR char rtc_lastModified[32];
 };
 
 #endif // NETWORK_MANAGER_H
@@ -0,0 +1,89 @@
+#ifndef OTA_UPDATER_H
+#define OTA_UPDATER_H
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include "DeltaPatch.h"
+#include "ImageSignature.h"
+#include "TlsClient.h"
+#include "config.h"
+
+// Longest version string and patch URL accepted from the API
+#define OTA_VERSION_SIZE 16
+#define OTA_URL_SIZE 160
+
+enum OtaTrialState : uint8_t {
+    OTA_TRIAL_NONE,
+    OTA_TRIAL_PENDING,      // new image booted, not confirmed yet
+    OTA_TRIAL_ROLLED_BACK   // new image failed, its version is not taken again
+};
+
+// Outcome of the last update, kept in RTC memory that is not reinitialized
+// on a software reset (RTC_DATA_ATTR is), so it survives the restart into
+// the new image and the rollback. A power cycle clears it.
+struct __attribute__((packed)) OtaTrial {
+    uint32_t magic;
+    uint8_t state;
+    uint8_t wakes;
+    uint32_t partition;  // flash address of the image on trial
+    char version[OTA_VERSION_SIZE];
+    uint32_t crc;
+};
+
+// Delta firmware updates into the inactive A/B app slot. The offer comes
+// with a normal API response; the patch is streamed through DeltaPatch, with
+// the running image as the base and esp_ota_write as the output, and the
+// new image boots on restart. Until it confirms itself with a successful
+// fetch, every wake (crashes included) counts against OTA_TRIAL_WAKES.
+// Updates are only taken from the API server over HTTPS with a pinned
+// certificate, and the new image must carry a valid ImageSignature.
+class OtaUpdater {
+public:
+    // First thing on every wake: rolls an unconfirmed image back once it
+    // has used up its trial wakes
+    static void begin();
+    // A fetch worked: the running image is good
+    static void confirm();
+
+    // Where updates come from: the API server (its pinned certificate and
+    // the key images are signed with). Set from config.h; the bench points
+    // it at its fake server.
+    static void setSource(const char* apiUrl, const char* certPin, const char* publicKey);
+    // OTA_ENABLED, and the source is https with a pin and a key
+    static bool enabled();
+
+    // "firmware" object of the response; the running version, one that was
+    // rolled back and unsigned ones are ignored
+    static void offer(const char* version, const char* url, const char* signature);
+    static bool hasOffer();
+    // Downloads and applies the offered patch; true when the new image is
+    // written and set to boot
+    static bool apply();
+    // The wake ends with a restart into the new image instead of deep sleep
+    static bool updateReady();
+
+private:
+    static bool readRunning(void* context, uint32_t offset, uint8_t* buffer, size_t size);
+    static bool writeUpdate(void* context, const uint8_t* bytes, size_t size);
+    static DeltaPatch::Result download(HTTPClient& http, DeltaPatch& patch);
+    // False if the offered URL isn't on the API server
+    static bool buildUrl(char* url, size_t size);
+    static void saveTrial(OtaTrialState state, uint32_t partition, const char* version);
+    static bool hasTrial();
+
+    // Offer of this wake's response, applied on the same wake
+    static char offerVersion[OTA_VERSION_SIZE];
+    static char offerUrl[OTA_URL_SIZE];
+    static char offerSignature[IMAGE_SIGNATURE_SIZE];
+    static bool ready;
+
+    static const char* sourceUrl;
+    static const char* sourcePin;
+    static const char* sourceKey;
+
+    static RTC_NOINIT_ATTR OtaTrial rtc_trial;
+};
+
+#endif // OTA_UPDATER_H
@@ -0,0 +1,42 @@
+#ifndef TIME_KEEPER_H
+#define TIME_KEEPER_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "config.h"
+#include "AdaptiveTimeout.h"
+#include "WakeProfiler.h"
+
+// Wall-clock time across deep sleep with occasional NTP re-sync
+class TimeKeeper {
+public:
+    static void restore();
+    static bool isTimeValid();
+    static bool needsSync();
+    static void beginSync();
+    // Waits until timeoutMs after beginSync() for the sync to complete
+    static bool finishSync(unsigned long timeoutMs);
+    static void prepareSleep(uint32_t sleepSeconds);
+    static time_t parseIsoTime(const char* isoTimestamp);
+    // strftime of the local time into buffer ("N/A" for epoch 0); returns
+    // the length
+    static size_t formatLocal(time_t epoch, const char* format, char* buffer, size_t size);
+    // Days since 1970-01-01 of the local date (TIMEZONE_OFFSET applied)
+    static int32_t localDay(time_t epoch);
+
+private:
+    static uint32_t estimatedDrift();
+    static void onTimeSync(struct timeval* tv);
+
+    // RTC memory variables
+    static RTC_DATA_ATTR time_t rtc_lastSyncEpoch;
+    static RTC_DATA_ATTR time_t rtc_sleepStartEpoch;
+    static RTC_DATA_ATTR uint32_t rtc_sleepSeconds;
+    static RTC_DATA_ATTR uint16_t rtc_wakesSinceSync;
+
+    static bool syncStarted;
+    static unsigned long syncStartMs;
+    static volatile unsigned long syncDoneMs;
+};
+
+#endif // TIME_KEEPER_H
@@ -0,0 +1,55 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "AdaptiveTimeout.h"
+#include "CircuitBreaker.h"
+#include "config.h"
+
+// HTTPS transport for HTTPClient: TLS 1.2 (mbedTLS) over a plain WiFiClient
+// socket. Only the server certificate pinned in API_CERT_SHA256 is accepted.
+// The session of the last handshake is kept in RTC memory and offered on the
+// next connect, so most wakes do an abbreviated handshake (no certificate,
+// no key exchange). One connection at a time, the TLS state is static.
+class TlsClient : public WiFiClient {
+public:
+    ~TlsClient();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const char* host, uint16_t port, int32_t timeout) override;
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size) override;
+    int peek() override;
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+
+    // TCP connect and handshake of the last connection (ms), 0 if none
+    unsigned long connectTime() const { return connectMs; }
+
+    // Forget the stored session (next handshake is a full one)
+    static void clearSession();
+
+private:
+    bool handshake(const char* host, uint16_t port);
+    void saveSession(uint32_t hostHash);
+    static uint32_t hashHost(const char* host, uint16_t port);
+    static bool parsePin(uint8_t* pin);
+
+    unsigned long connectMs = 0;
+
+    // Session of the last handshake (persists across deep sleep)
+    static RTC_DATA_ATTR uint8_t rtc_session[TLS_SESSION_SIZE];
+    static RTC_DATA_ATTR uint16_t rtc_sessionLength;
+    static RTC_DATA_ATTR uint32_t rtc_sessionHost;
+    static RTC_DATA_ATTR uint16_t rtc_fullHandshakes;
+    static RTC_DATA_ATTR uint16_t rtc_resumedHandshakes;
+};
+
+#endif // TLS_CLIENT_H
@@ -0,0 +1,59 @@
+#ifndef WAKE_PROFILER_H
+#define WAKE_PROFILER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Phases of a wake cycle, in the order they normally run
+enum WakePhase : uint8_t {
+    PHASE_BOOT,
+    PHASE_DISPLAY_INIT,
+    PHASE_SCAN,
+    PHASE_ASSOCIATE,
+    PHASE_NTP,
+    PHASE_HTTP,
+    PHASE_PARSE,
+    PHASE_RENDER,
+    PHASE_HIBERNATE,
+    PHASE_COUNT
+};
+
+// Timings and conditions of one wake cycle
+struct __attribute__((packed)) WakeRecord {
+    uint16_t phaseMs[PHASE_COUNT];
+    uint8_t resetReason;
+    uint8_t wakeCause;
+    int8_t rssi;
+    uint16_t minFreeHeapKb;
+};
+
+// Longest text of one record in formatPending(): separator, reset reason and
+// wake cause (3 digits each), RSSI (4), heap (5), four commas, and every
+// phase (5 digits) with dots between
+constexpr size_t WAKE_PROFILE_RECORD_MAX = 1 + 3 + 3 + 4 + 5 + 4 + PHASE_COUNT * 5 + (PHASE_COUNT - 1);
+// Buffer for all pending records: "1;", the records and the terminator
+constexpr size_t WAKE_PROFILE_TEXT_SIZE = 2 + WAKE_PROFILE_HISTORY * WAKE_PROFILE_RECORD_MAX + 1;
+
+// Per-phase wake timing, buffered in RTC memory until it can be uploaded
+class WakeProfiler {
+public:
+    static void begin();
+    static void start(WakePhase phase);
+    static void stop(WakePhase phase);
+    static void setRssi(int8_t rssi);
+    static void commit();
+    static bool hasPending();
+    static size_t formatPending(char* buffer, size_t size);
+    static void clearPending();
+
+private:
+    static WakeRecord current;
+    static int64_t phaseStart[PHASE_COUNT];
+
+    // RTC memory ring buffer of completed wakes
+    static RTC_DATA_ATTR WakeRecord rtc_records[WAKE_PROFILE_HISTORY];
+    static RTC_DATA_ATTR uint8_t rtc_head;
+    static RTC_DATA_ATTR uint8_t rtc_count;
+};
+
+#endif // WAKE_PROFILER_H
@@ -0,0 +1,52 @@
+#ifndef WAKE_SCHEDULER_H
+#define WAKE_SCHEDULER_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "GoalData.h"
+#include "CircuitBreaker.h"
+#include "TimeKeeper.h"
+#include "config.h"
+
+// One fetch in the change history: time since the previous fetch and
+// whether the displayed values moved
+struct ChangeRecord {
+    uint16_t minutes;
+    bool changed;
+};
+
+// Picks the deep sleep interval from how often the goal data changes, server
+// hints and quiet hours, and which wakes use the network (several goals, or
+// local updates between fetches)
+class WakeScheduler {
+public:
+    // Clears what the last wake's fetch left for its sleep plan
+    static void beginWake();
+    static bool fetchDue();
+    static void recordFetch(const GoalData& data);
+    static void setServerHint(uint32_t seconds);
+    static uint32_t planSleep();
+
+private:
+    static bool localUpdates();
+    static uint32_t untilDayChange(uint32_t seconds);
+    static uint32_t adaptiveInterval();
+    static uint32_t skipQuietHours(uint32_t seconds);
+    static bool isQuietHour(int hour);
+
+    // RTC memory variables
+    static RTC_DATA_ATTR ChangeRecord rtc_history[CHANGE_HISTORY];
+    static RTC_DATA_ATTR uint8_t rtc_historyCount;
+    static RTC_DATA_ATTR uint8_t rtc_historyHead;
+    static RTC_DATA_ATTR uint32_t rtc_secondsSinceFetch;
+    static RTC_DATA_ATTR int32_t rtc_lastDays;
+    static RTC_DATA_ATTR int16_t rtc_lastProgressTenths;
+    static RTC_DATA_ATTR bool rtc_hasLast;
+    static RTC_DATA_ATTR uint8_t rtc_wakesSinceAttempt;
+    static RTC_DATA_ATTR uint32_t rtc_serverUpdateEpoch;
+
+    static bool fetchedThisWake;
+    static uint32_t hintSeconds;
+};
+
+#endif // WAKE_SCHEDULER_H
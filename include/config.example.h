@@ -12,16 +12,108 @@ constexpr const char* WIFI_SSID = "YOUR_WIFI_SSID";
 // Replace with your WiFi password
 constexpr const char* WIFI_PASSWORD = "YOUR_WIFI_PASSWORD";
 
+// Fast reconnect: reuse the last AP (BSSID + channel) and DHCP lease from RTC memory
+// Timeout for the cached-AP attempt before falling back to scanning (milliseconds)
+constexpr unsigned long WIFI_FAST_CONNECT_TIMEOUT = 5000;
+// Run DHCP again once the reused lease is this old (seconds); keep it below
+// half the router's lease time so the address is never handed out again
+constexpr uint32_t WIFI_STATIC_IP_MAX_AGE = 4 * 3600;
+
 // Timezone offset in seconds
 // Examples: -18000 (EST), -28800 (PST), 3600 (CET), 0 (UTC)
 constexpr long TIMEZONE_OFFSET = 0;
 
+// NTP re-sync policy: the clock keeps running across deep sleep, so NTP is only
+// queried every NTP_SYNC_EVERY_WAKES wakes, or sooner when the estimated clock
+// drift exceeds MAX_CLOCK_DRIFT seconds
+constexpr uint16_t NTP_SYNC_EVERY_WAKES = 24;
+constexpr uint32_t MAX_CLOCK_DRIFT = 300;
+// Assumed accuracy of the RTC clock during deep sleep (parts per million)
+constexpr uint32_t RTC_DRIFT_PPM = 10000;
+
 // ===== API CONFIGURATION =====
 // Replace with your server's IP address and port
 constexpr const char* API_URL = "http://YOUR_SERVER_IP:4000/api/portfolio/summary";
 // Replace with your API authorization token
 constexpr const char* API_TOKEN = "YOUR_API_TOKEN_HERE";
 
+// HTTPS: with an https:// API_URL only a server certificate with this SHA-256
+// fingerprint is accepted (hex, colons optional), e.g. from
+//   openssl x509 -noout -fingerprint -sha256 -in cert.pem
+// Update it when the server's certificate is renewed.
+constexpr const char* API_CERT_SHA256 = "";
+// RTC memory kept for the TLS session, so later wakes can resume it instead
+// of doing a full handshake (the session includes the server certificate)
+constexpr size_t TLS_SESSION_SIZE = 2048;
+
+// Number of goals. With more than one, the API returns them all in one
+// response ({"goals": [...]}, see README) and each wake shows the next goal
+// (pages turn every UPDATE_INTERVAL).
+// Without FETCH_INTERVAL the network is only used every FETCH_EVERY_WAKES
+// wakes, or sooner when the server's announced update time (next_update_at /
+// max-age) has passed; the pages in between come from RTC memory.
+constexpr uint8_t GOAL_COUNT = 1;
+constexpr uint8_t FETCH_EVERY_WAKES = 4;
+
+// Ask the API for MessagePack (Accept: application/msgpack). It is smaller
+// than JSON and parses without text scanning; servers that only speak JSON
+// keep answering JSON, which is still accepted.
+constexpr bool PREFER_MSGPACK = true;
+
+// Largest API response accepted (bytes). The body is parsed while streaming,
+// anything beyond this is rejected instead of exhausting the heap.
+constexpr size_t MAX_RESPONSE_SIZE = 32768;
+
+// Number of past wake cycles whose phase timings are kept in RTC memory and
+// sent to the API (X-Wake-Profile header) with the next successful request
+constexpr uint8_t WAKE_PROFILE_HISTORY = 8;
+
+// ===== FIRMWARE UPDATES =====
+// Over-the-air updates as binary deltas. Requests carry FIRMWARE_VERSION
+// (X-Firmware-Version header); when the server has another image it adds a
+// "firmware" object to the response, and the patch from the running image
+// (tools/make_delta.py) is downloaded on the same wake and applied into the
+// inactive app slot, which boots next. A new image that doesn't complete a
+// fetch within OTA_TRIAL_WAKES wakes is rolled back. Needs an https:// API_URL
+// with API_CERT_SHA256 set and OTA_PUBLIC_KEY; otherwise updates stay off.
+constexpr bool OTA_ENABLED = false;
+// ECDSA P-256 public key (PEM) the images are signed with, e.g. from
+//   openssl ecparam -name prime256v1 -genkey -noout -out ota-key.pem
+//   openssl ec -in ota-key.pem -pubout
+// Keep ota-key.pem off the server; tools/make_delta.py --sign uses it.
+constexpr const char* OTA_PUBLIC_KEY = "";
+constexpr uint8_t OTA_TRIAL_WAKES = 3;
+// Time allowed for downloading and applying a patch (milliseconds)
+constexpr unsigned long OTA_TIMEOUT = 60000;
+
+// ===== FAILURE HANDLING =====
+// Time budget for the network phases of one wake (milliseconds). Timeouts are
+// cut to what is left, and phases that would start after it has run out are
+// skipped.
+constexpr unsigned long WAKE_TIME_BUDGET = 30000;
+// After a failed fetch the device retries at UPDATE_INTERVAL, then doubles
+// the interval per failed wake up to MAX_BACKOFF_INTERVAL
+constexpr unsigned long MAX_BACKOFF_INTERVAL = 43200000; // 12 hours
+// NTP is skipped after BREAKER_FAILURE_LIMIT consecutive failures and only
+// retried every BREAKER_PROBE_EVERY wakes until it succeeds again. The WiFi
+// and HTTP breakers open after as many failed wakes; the backoff above
+// spaces their probes.
+constexpr uint8_t BREAKER_FAILURE_LIMIT = 3;
+constexpr uint8_t BREAKER_PROBE_EVERY = 4;
+// Failed wakes before the offline state is drawn; shorter outages don't
+// cost a display refresh
+constexpr uint8_t OFFLINE_REDRAW_AFTER = 3;
+// Adaptive timeouts: the WiFi association, NTP, HTTP response and TLS
+// handshake waits time out at the 95th percentile of their latencies on
+// recent wakes (kept in RTC memory) times TIMEOUT_MARGIN_PERCENT, instead of
+// at fixed worst cases. The fixed values stay the ceiling and apply until a
+// phase has TIMEOUT_MIN_SAMPLES latencies, and for a probe wait after a
+// timeout. A success slower than the learned timeout, or a new access point,
+// starts the learning over.
+constexpr bool ADAPTIVE_TIMEOUTS = true;
+constexpr uint16_t TIMEOUT_MARGIN_PERCENT = 150;
+constexpr uint8_t TIMEOUT_MIN_SAMPLES = 8;
+
 // Mock mode for testing (set to true to use test data instead of real API)
 // Useful for testing display without WiFi or API server running
 constexpr bool MOCK_MODE = false;
@@ -29,14 +121,16 @@ constexpr bool MOCK_MODE = false;
 // Debug mode - enable Serial output for debugging (set to false to save power and flash)
 #define DEBUG_MODE true
 
-// Debug macros
-#if DEBUG_MODE
-    #define DEBUG_PRINT(x) Serial.print(x)
-    #define DEBUG_PRINTLN(x) Serial.println(x)
-#else
-    #define DEBUG_PRINT(x)
-    #define DEBUG_PRINTLN(x)
-#endif
+// Serial log level (LOG_LEVEL_NONE, _ERROR, _WARN, _INFO or _DEBUG, see
+// Log.h). Messages above it are compiled out. Only debug builds wait for the
+// USB console after boot.
+#define LOG_LEVEL (DEBUG_MODE ? LOG_LEVEL_DEBUG : LOG_LEVEL_NONE)
+// Messages up to LOG_RTC_LEVEL are also kept in an RTC ring of
+// LOG_RTC_ENTRIES records (17 bytes each) and sent to the API with the next
+// successful request (X-Device-Log header), so units without a console can
+// still be diagnosed. LOG_RTC_ENTRIES = 0 turns it off.
+#define LOG_RTC_LEVEL LOG_LEVEL_WARN
+constexpr uint8_t LOG_RTC_ENTRIES = 16;
 
 // ===== DISPLAY CONFIGURATION =====
 // Update interval (in milliseconds) - device will deep sleep between updates
@@ -47,6 +141,29 @@ constexpr bool MOCK_MODE = false;
 //   300000 = 5 minutes (for testing only - reduces battery life)
 constexpr unsigned long UPDATE_INTERVAL = 3600000; // 1 hour
 
+// Adaptive schedule: UPDATE_INTERVAL is the shortest sleep. While the data
+// doesn't change, the interval grows towards MAX_UPDATE_INTERVAL (half the
+// average time between changes over the last CHANGE_HISTORY fetches).
+// A server hint (Cache-Control: max-age or "next_update_at" in the response)
+// takes precedence.
+constexpr bool ADAPTIVE_SCHEDULE = true;
+constexpr unsigned long MAX_UPDATE_INTERVAL = 21600000; // 6 hours
+constexpr uint8_t CHANGE_HISTORY = 8;
+
+// Local updates: between network fetches, wakes count daysToGoal down from
+// the cached data and the RTC clock, redrawing only when the count changes,
+// with WiFi off. The network is used once FETCH_INTERVAL has passed since
+// the last fetch, sooner when the server's announced update time has passed
+// or after a failed fetch. A wake is planned just after local midnight so
+// the count changes on the day. Replaces the adaptive schedule and
+// FETCH_EVERY_WAKES while the clock is valid. 0 = fetch on every wake.
+constexpr unsigned long FETCH_INTERVAL = 86400000; // 24 hours
+
+// Quiet hours (local time): no wakes from QUIET_HOURS_START until
+// QUIET_HOURS_END. Set both to the same hour to disable.
+constexpr uint8_t QUIET_HOURS_START = 23;
+constexpr uint8_t QUIET_HOURS_END = 6;
+
 // E-ink display pins (240x416 display) - ESP32-C3 Super Mini
 // Based on WeAct Studio example: CS=7, SCK=4, MOSI=6, BUSY=3, RST=2, DC=1
 // IMPORTANT: GPIO8 must be HIGH to power the display!
@@ -60,7 +177,34 @@ constexpr unsigned long UPDATE_INTERVAL = 3600000; // 1 hour
 #define EPD_MOSI 6        // SDA/MOSI - Data to display
 #define EPD_SCK 4         // SCL/SCK - Clock
 
+// Partial refresh: only redraw the regions that changed since the last wake
+// (faster and no flashing). A full refresh still runs every FULL_REFRESH_EVERY
+// updates to clear ghosting.
+constexpr bool PARTIAL_REFRESH = true;
+constexpr uint8_t FULL_REFRESH_EVERY = 12;
+
+// Light sleep while the panel refreshes (seconds of BUSY), woken by the
+// BUSY line instead of polling it. The USB serial console drops out during
+// light sleep, so debug builds keep polling.
+constexpr bool BUSY_LIGHT_SLEEP = !DEBUG_MODE;
+
+// Days of progress history kept in RTC memory and drawn as a trend line
+// next to the percentage (4 bytes of RTC memory per day)
+constexpr uint8_t TREND_HISTORY_DAYS = 30;
+
 // Display rotation: 0 = portrait, 1 = landscape, 2 = portrait inverted, 3 = landscape inverted
 #define DISPLAY_ROTATION 1
 
+// Panel driver (a GxEPD2 class) and the screen layout for it at
+// DISPLAY_ROTATION, from DisplayLayout.h. The build fails if the layout
+// doesn't match the panel size or an element doesn't fit.
+//   GxEPD2_370_GDEY037T03 + LAYOUT_416X240 (3.7", landscape at rotation 1)
+//   GxEPD2_420_GDEY042T81 + LAYOUT_400X300 (4.2", landscape at rotation 0)
+#define DISPLAY_PANEL GxEPD2_370_GDEY037T03
+#define DISPLAY_LAYOUT LAYOUT_416X240
+
+// Framebuffer limit in bytes. Panels with a bigger frame are drawn in pages
+// (the goal screen is rendered once per page).
+constexpr uint32_t DISPLAY_BUFFER_SIZE = 16384;
+
 #endif // CONFIG_H
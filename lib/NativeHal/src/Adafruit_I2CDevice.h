@@ -0,0 +1,8 @@
+#ifndef NATIVE_HAL_ADAFRUIT_I2CDEVICE_H
+#define NATIVE_HAL_ADAFRUIT_I2CDEVICE_H
+
+// Adafruit GFX includes the BusIO headers unconditionally, but only its OLED
+// and SPI TFT drivers use them. Those are compiled out in the native build
+// (see [env:native]), so empty headers are enough.
+
+#endif // NATIVE_HAL_ADAFRUIT_I2CDEVICE_H
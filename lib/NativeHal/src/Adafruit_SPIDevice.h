@@ -0,0 +1,6 @@
+#ifndef NATIVE_HAL_ADAFRUIT_SPIDEVICE_H
+#define NATIVE_HAL_ADAFRUIT_SPIDEVICE_H
+
+// See Adafruit_I2CDevice.h
+
+#endif // NATIVE_HAL_ADAFRUIT_SPIDEVICE_H
@@ -0,0 +1,323 @@
+#include "Arduino.h"
+#include "esp_timer.h"
+#include <stdarg.h>
+#include <malloc.h>
+#include <chrono>
+#include <new>
+
+HostSerial Serial;
+EspClass ESP;
+
+// ===== Virtual clock =====
+
+static unsigned long long virtualOffsetUs = 0;
+
+static unsigned long long hostMicros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)(hostMicros() + virtualOffsetUs);
+}
+
+unsigned long millis() {
+    return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)esp_timer_get_time();
+}
+
+void delay(unsigned long ms) {
+    virtualOffsetUs += (unsigned long long)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+    virtualOffsetUs += us;
+}
+
+void yield() {}
+
+// The native build links with -Wl,--wrap=time so wall-clock time moves with
+// the virtual clock too (simulated sleeps advance the date)
+extern "C" {
+time_t __real_time(time_t* out);
+
+time_t __wrap_time(time_t* out) {
+    time_t now = __real_time(nullptr) + (time_t)(virtualOffsetUs / 1000000);
+    if (out) {
+        *out = now;
+    }
+    return now;
+}
+}
+
+// ===== GPIO =====
+
+static uint8_t pinLevels[64];
+
+// One pending scripted change per pin (0 = none)
+static int64_t pinChangeUs[64];
+static uint8_t pinChangeLevel[64];
+
+static void applyPinChange(uint8_t pin) {
+    if (pinChangeUs[pin] != 0 && esp_timer_get_time() >= pinChangeUs[pin]) {
+        pinLevels[pin] = pinChangeLevel[pin];
+        pinChangeUs[pin] = 0;
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < sizeof(pinLevels)) {
+        pinLevels[pin] = value;
+        pinChangeUs[pin] = 0;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin >= sizeof(pinLevels)) {
+        return LOW;
+    }
+    applyPinChange(pin);
+    return pinLevels[pin];
+}
+
+void FakeGpio::setLevel(uint8_t pin, uint8_t level) {
+    digitalWrite(pin, level);
+}
+
+void FakeGpio::scheduleLevel(uint8_t pin, uint8_t level, unsigned long afterMs) {
+    pinChangeUs[pin] = esp_timer_get_time() + (int64_t)afterMs * 1000;
+    pinChangeLevel[pin] = level;
+}
+
+int64_t FakeGpio::nextLevelTime(uint8_t pin, uint8_t level) {
+    if (digitalRead(pin) == level) {
+        return esp_timer_get_time();
+    }
+    return pinChangeUs[pin] != 0 && pinChangeLevel[pin] == level ? pinChangeUs[pin] : -1;
+}
+
+// ===== Print =====
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(long number, int base) {
+    if (base == DEC) {
+        char text[24];
+        snprintf(text, sizeof(text), "%ld", number);
+        return write(text);
+    }
+    return print((unsigned long)number, base);
+}
+
+size_t Print::print(unsigned long number, int base) {
+    char text[72];
+    if (base == HEX) {
+        snprintf(text, sizeof(text), "%lX", number);
+    } else {
+        snprintf(text, sizeof(text), "%lu", number);
+    }
+    return write(text);
+}
+
+size_t Print::print(double number, int digits) {
+    // Same rounding as the Arduino core's printFloat
+    if (isnan(number)) return write("nan");
+    if (isinf(number)) return write("inf");
+
+    size_t n = 0;
+    if (number < 0.0) {
+        n += print('-');
+        number = -number;
+    }
+
+    double rounding = 0.5;
+    for (int i = 0; i < digits; i++) {
+        rounding /= 10.0;
+    }
+    number += rounding;
+
+    unsigned long integer = (unsigned long)number;
+    double remainder = number - (double)integer;
+    n += print(integer);
+
+    if (digits > 0) {
+        n += print('.');
+    }
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int digit = (unsigned int)remainder;
+        n += print(digit);
+        remainder -= digit;
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)text, min((size_t)len, sizeof(text) - 1));
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = read();
+        if (c < 0) {
+            break;
+        }
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+size_t HostSerial::write(uint8_t c) {
+    if (!muted) {
+        fputc(c, stdout);
+    }
+    return 1;
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t size) {
+    if (!muted) {
+        fwrite(buffer, 1, size, stdout);
+    }
+    return size;
+}
+
+String IPAddress::toString() const {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", address & 0xFF, (address >> 8) & 0xFF,
+             (address >> 16) & 0xFF, (address >> 24) & 0xFF);
+    return String(text);
+}
+
+// ===== Heap accounting =====
+// The native build links with -Wl,--wrap=malloc,... so every C allocation
+// (ArduinoJson included) lands here; C++ new/delete are routed to malloc.
+
+#define HOST_HEAP_SIZE (320 * 1024)
+
+static uint32_t heapAllocations = 0;
+static uint32_t heapInUse = 0;
+static uint32_t heapPeak = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+static void trackAlloc(void* ptr) {
+    if (ptr) {
+        heapAllocations++;
+        heapInUse += malloc_usable_size(ptr);
+        heapPeak = max(heapPeak, heapInUse);
+    }
+}
+
+static void trackFree(void* ptr) {
+    if (ptr) {
+        // Clamp in case libc frees something it allocated before wrapping
+        uint32_t size = malloc_usable_size(ptr);
+        heapInUse = size > heapInUse ? 0 : heapInUse - size;
+    }
+}
+
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    trackAlloc(ptr);
+    return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    trackAlloc(ptr);
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    trackFree(ptr);
+    void* result = __real_realloc(ptr, size);
+    trackAlloc(result ? result : ptr);
+    return result;
+}
+
+void __wrap_free(void* ptr) {
+    trackFree(ptr);
+    __real_free(ptr);
+}
+}
+
+void* operator new(size_t size) {
+    void* ptr = malloc(size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+uint32_t EspClass::getHeapSize() {
+    return HOST_HEAP_SIZE;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return HOST_HEAP_SIZE - heapInUse;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return HOST_HEAP_SIZE - heapPeak;
+}
+
+uint32_t HostHeap::allocations() {
+    return heapAllocations;
+}
+
+uint32_t HostHeap::bytesInUse() {
+    return heapInUse;
+}
+
+uint32_t HostHeap::peakBytes() {
+    return heapPeak;
+}
+
+void HostHeap::resetPeak() {
+    heapPeak = heapInUse;
+}
@@ -0,0 +1,197 @@
+#ifndef NATIVE_HAL_ARDUINO_H
+#define NATIVE_HAL_ARDUINO_H
+
+// Host stand-in for the subset of the Arduino-ESP32 core used by the firmware.
+// Only compiled in the native build (see [env:native] in platformio.ini).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// RTC memory is ordinary memory on the host
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_pointer(addr) ((void*)*(void* const*)(addr))
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+#define DEC 10
+#define HEX 16
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// Flash strings are plain strings on the host
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper*>(text))
+
+// Time is virtual: delay() advances the clock (and time()) instead of
+// sleeping, so simulated timeouts, polling loops and sleeps run instantly
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+class String {
+public:
+    String() {}
+    String(const char* text) : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    explicit String(int number) : value(std::to_string(number)) {}
+    explicit String(unsigned int number) : value(std::to_string(number)) {}
+    explicit String(long number) : value(std::to_string(number)) {}
+    explicit String(unsigned long number) : value(std::to_string(number)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.length(); }
+    bool isEmpty() const { return value.empty(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* other) { value += other; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == other; }
+    bool operator!=(const String& other) const { return value != other.value; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+    friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+
+private:
+    std::string value;
+};
+
+class IPAddress {
+public:
+    IPAddress() : address(0) {}
+    IPAddress(uint32_t address) : address(address) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    operator uint32_t() const { return address; }
+    String toString() const;
+
+private:
+    uint32_t address;
+};
+
+#ifndef INADDR_NONE
+#define INADDR_NONE IPAddress((uint32_t)0)
+#endif
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int number, int base = DEC) { return print((long)number, base); }
+    size_t print(unsigned int number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(long number, int base = DEC);
+    size_t print(unsigned long number, int base = DEC);
+    size_t print(long long number, int base = DEC) { return print((long)number, base); }
+    size_t print(unsigned long long number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(double number, int digits = 2);
+    size_t print(const IPAddress& address) { return print(address.toString()); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T>
+    size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(char* buffer, size_t length);
+    void setTimeout(unsigned long timeout) { timeoutMs = timeout; }
+    unsigned long getTimeout() const { return timeoutMs; }
+
+protected:
+    unsigned long timeoutMs = 1000;
+};
+
+// Serial console on stdout; can be muted so benchmarks aren't measuring printf
+class HostSerial : public Stream {
+public:
+    void begin(unsigned long baud) {}
+    void flush() { fflush(stdout); }
+    void setMuted(bool value) { muted = value; }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    bool muted = false;
+};
+
+extern HostSerial Serial;
+
+// Scripted input levels: a pin can be set to change level at a point of
+// the virtual clock, e.g. the panel's BUSY line ending a refresh
+class FakeGpio {
+public:
+    static void setLevel(uint8_t pin, uint8_t level);
+    static void scheduleLevel(uint8_t pin, uint8_t level, unsigned long afterMs);
+    // Virtual time (us) when the pin next reads `level`, -1 if never
+    static int64_t nextLevelTime(uint8_t pin, uint8_t level);
+};
+
+// Heap statistics of a simulated ESP32-C3 (all host allocations are counted)
+class EspClass {
+public:
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+};
+
+extern EspClass ESP;
+
+// Allocation counters backing EspClass, for benchmarks
+class HostHeap {
+public:
+    static uint32_t allocations();
+    static uint32_t bytesInUse();
+    static uint32_t peakBytes();
+    static void resetPeak();
+};
+
+#endif // NATIVE_HAL_ARDUINO_H
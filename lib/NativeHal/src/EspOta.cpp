@@ -0,0 +1,110 @@
+#include "Arduino.h"
+#include "esp_ota_ops.h"
+
+// Erased flash reads as 0xFF
+static const uint32_t SLOT_SIZE = 0x1E0000;
+static esp_partition_t slots[2] = {{0x10000, SLOT_SIZE, "app0"}, {0x1F0000, SLOT_SIZE, "app1"}};
+static std::string contents[2];
+static int running = 0;
+static int boot = 0;
+static int writing = -1;
+static unsigned int restartCount = 0;
+static bool valid = false;
+
+static int slotIndex(const esp_partition_t* partition) {
+    return partition == &slots[1] ? 1 : 0;
+}
+
+void FakeFlash::reset(const std::string& runningImage) {
+    contents[0] = runningImage;
+    contents[0].resize(SLOT_SIZE, (char)0xFF);
+    contents[1].assign(SLOT_SIZE, (char)0xFF);
+    running = boot = 0;
+    writing = -1;
+    restartCount = 0;
+    valid = false;
+}
+
+std::string FakeFlash::image(const esp_partition_t* partition) {
+    return contents[slotIndex(partition)];
+}
+
+unsigned int FakeFlash::restarts() {
+    return restartCount;
+}
+
+bool FakeFlash::validated() {
+    return valid;
+}
+
+void esp_restart() {
+    running = boot;
+    valid = false;
+    restartCount++;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst,
+                             size_t size) {
+    if (src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, contents[slotIndex(partition)].data() + src_offset, size);
+    return ESP_OK;
+}
+
+const esp_partition_t* esp_ota_get_running_partition() {
+    return &slots[running];
+}
+
+const esp_partition_t* esp_ota_get_boot_partition() {
+    return &slots[boot];
+}
+
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from) {
+    return &slots[1 - running];
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle) {
+    if (slotIndex(partition) == running) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    writing = slotIndex(partition);
+    contents[writing].clear();
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size) {
+    if (writing < 0 || contents[writing].size() + size > SLOT_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    contents[writing].append((const char*)data, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+    if (writing < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Like ESP-IDF, only an image with the app magic byte is accepted
+    std::string& image = contents[writing];
+    bool ok = !image.empty() && (uint8_t)image[0] == 0xE9;
+    image.resize(SLOT_SIZE, (char)0xFF);
+    writing = -1;
+    return ok ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+    writing = -1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition) {
+    boot = slotIndex(partition);
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+    valid = true;
+    return ESP_OK;
+}
@@ -0,0 +1,118 @@
+#include "Arduino.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_sleep.h"
+#include "esp_sntp.h"
+#include "esp_wifi.h"
+#include "driver/gpio.h"
+
+static sntp_sync_status_t syncStatus = SNTP_SYNC_STATUS_RESET;
+static sntp_sync_time_cb_t syncCallback = nullptr;
+
+// Light sleep wake sources
+static uint64_t timerWakeUs = 0;
+static bool gpioWake = false;
+static int wakePin = -1;
+static uint8_t wakeLevel = LOW;
+
+esp_reset_reason_t esp_reset_reason() {
+    return ESP_RST_DEEPSLEEP;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return ESP_SLEEP_WAKEUP_TIMER;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+    timerWakeUs = time_in_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+    gpioWake = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source) {
+    if (source == ESP_SLEEP_WAKEUP_TIMER || source == ESP_SLEEP_WAKEUP_ALL) {
+        timerWakeUs = 0;
+    }
+    if (source == ESP_SLEEP_WAKEUP_GPIO || source == ESP_SLEEP_WAKEUP_ALL) {
+        gpioWake = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    if (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL) {
+        return ESP_FAIL;
+    }
+    wakePin = gpio_num;
+    wakeLevel = intr_type == GPIO_INTR_HIGH_LEVEL ? HIGH : LOW;
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) {
+    if (wakePin == gpio_num) {
+        wakePin = -1;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_sleep_sel_dis(gpio_num_t gpio_num) {
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start() {
+    int64_t now = esp_timer_get_time();
+    int64_t wakeAt = timerWakeUs > 0 ? now + (int64_t)timerWakeUs : -1;
+    if (gpioWake && wakePin >= 0) {
+        int64_t level = FakeGpio::nextLevelTime((uint8_t)wakePin, wakeLevel);
+        if (level >= 0 && (wakeAt < 0 || level < wakeAt)) {
+            wakeAt = level;
+        }
+    }
+    if (wakeAt < 0) {
+        return ESP_FAIL;  // no wake source, ESP-IDF refuses too
+    }
+    for (int64_t left = wakeAt - now; left > 0; left -= 1000000) {
+        delayMicroseconds((unsigned int)min(left, (int64_t)1000000));
+    }
+    return ESP_OK;
+}
+
+uint64_t FakeSleep::timerWakeUs() {
+    return ::timerWakeUs;
+}
+
+bool FakeSleep::gpioWake() {
+    return ::gpioWake;
+}
+
+esp_err_t esp_wifi_set_max_tx_power(int8_t power) {
+    return ESP_OK;
+}
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec, const char* server1,
+                const char* server2, const char* server3) {
+    // The host clock is already correct, the sync completes immediately
+    syncStatus = SNTP_SYNC_STATUS_COMPLETED;
+    if (syncCallback) {
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        syncCallback(&tv);
+    }
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+    syncCallback = callback;
+}
+
+sntp_sync_status_t sntp_get_sync_status() {
+    // Like ESP-IDF, COMPLETED is reported once and then resets
+    sntp_sync_status_t status = syncStatus;
+    if (status == SNTP_SYNC_STATUS_COMPLETED) {
+        syncStatus = SNTP_SYNC_STATUS_RESET;
+    }
+    return status;
+}
@@ -0,0 +1,168 @@
+#include "HTTPClient.h"
+#include "WiFi.h"
+#include <strings.h>
+
+static FakeResponse response = {200, "{}", {}, 50};
+static std::vector<std::pair<std::string, FakeResponse>> routes;
+static const FakeResponse* active = &response;
+static std::string requestUrl;
+static std::string lastRequestUrl;
+static std::vector<std::pair<std::string, std::string>> requestHeaders;
+static std::vector<std::pair<std::string, std::string>> lastRequestHeaders;
+static unsigned int requests = 0;
+static unsigned int timeouts = 0;
+static size_t bodyRead = 0;
+static FakeBodyStream bodyStream;
+
+void FakeBodyStream::reset(const std::string& body, size_t segment, unsigned long gap) {
+    data = body;
+    position = 0;
+    segmentBytes = segment;
+    gapMs = gap;
+    startMs = millis();
+}
+
+size_t FakeBodyStream::arrived() {
+    if (segmentBytes == 0 || gapMs == 0) {
+        return data.size();
+    }
+    size_t segments = (millis() - startMs) / gapMs + 1;
+    return min(data.size(), segments * segmentBytes);
+}
+
+size_t FakeBodyStream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length && position < data.size()) {
+        size_t n = min(length - count, arrived() - position);
+        if (n == 0) {
+            // Nothing buffered: wait for the next segment, or time out
+            unsigned long waitMs = gapMs - (millis() - startMs) % gapMs;
+            if (waitMs > timeoutMs) {
+                delay(timeoutMs);
+                break;
+            }
+            delay(waitMs);
+            continue;
+        }
+        memcpy(buffer + count, data.data() + position, n);
+        position += n;
+        count += n;
+    }
+    return count;
+}
+
+void FakeHttp::reset() {
+    response = {200, "{}", {}, 50};
+    routes.clear();
+    active = &response;
+    requestHeaders.clear();
+    lastRequestHeaders.clear();
+    requests = 0;
+    timeouts = 0;
+}
+
+void FakeHttp::setResponse(const FakeResponse& value) {
+    response = value;
+}
+
+void FakeHttp::setRoute(const char* path, const FakeResponse& value) {
+    routes.emplace_back(path, value);
+    active = &response;
+}
+
+unsigned int FakeHttp::requestCount() {
+    return requests;
+}
+
+unsigned int FakeHttp::timeoutCount() {
+    return timeouts;
+}
+
+String FakeHttp::lastRequestHeader(const char* name) {
+    for (const auto& header : lastRequestHeaders) {
+        if (strcasecmp(header.first.c_str(), name) == 0) {
+            return String(header.second);
+        }
+    }
+    return String();
+}
+
+String FakeHttp::lastUrl() {
+    return String(lastRequestUrl);
+}
+
+size_t FakeHttp::bodyBytesRead() {
+    return bodyRead;
+}
+
+static const FakeResponse& route(const std::string& url) {
+    for (const auto& entry : routes) {
+        const std::string& path = entry.first;
+        if (url.size() >= path.size() && url.compare(url.size() - path.size(), path.size(), path) == 0) {
+            return entry.second;
+        }
+    }
+    return response;
+}
+
+bool HTTPClient::begin(const String& url) {
+    requestUrl = url.c_str();
+    requestHeaders.clear();
+    return true;
+}
+
+void HTTPClient::end() {
+    bodyRead = bodyStream.consumed();
+    bodyStream.reset("");
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+    requestHeaders.emplace_back(name.c_str(), value.c_str());
+}
+
+void HTTPClient::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    // All response headers are available in the fake
+}
+
+int HTTPClient::GET() {
+    if (WiFi.status() != WL_CONNECTED) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    requests++;
+    bodyRead = 0;
+    lastRequestHeaders = requestHeaders;
+    lastRequestUrl = requestUrl;
+    active = &route(requestUrl);
+    if (active->latencyMs > timeoutMs) {
+        delay(timeoutMs);
+        timeouts++;
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    delay(active->latencyMs);
+    bodyStream.setTimeout(timeoutMs);
+    bodyStream.reset(active->body, active->segmentBytes, active->segmentGapMs);
+    return active->code;
+}
+
+int HTTPClient::getSize() {
+    return (int)active->body.size();
+}
+
+String HTTPClient::header(const char* name) {
+    for (const auto& header : active->headers) {
+        if (strcasecmp(header.first.c_str(), name) == 0) {
+            return String(header.second);
+        }
+    }
+    return String();
+}
+
+Stream& HTTPClient::getStream() {
+    return bodyStream;
+}
+
+String HTTPClient::getString() {
+    std::string body(active->body.size(), '\0');
+    body.resize(bodyStream.readBytes(&body[0], body.size()));
+    return String(body);
+}
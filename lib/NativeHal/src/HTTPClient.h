@@ -0,0 +1,87 @@
+#ifndef NATIVE_HAL_HTTPCLIENT_H
+#define NATIVE_HAL_HTTPCLIENT_H
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include <utility>
+#include <vector>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// Body of the simulated response as a socket delivers it: segments of
+// `segmentBytes` arrive `gapMs` apart on the virtual clock. Between them
+// available() is 0 and read() returns -1 without waiting; readBytes()
+// waits for the next segment up to the stream timeout.
+class FakeBodyStream : public Stream {
+public:
+    void reset(const std::string& body, size_t segmentBytes = 0, unsigned long gapMs = 0);
+    int available() override { return (int)(arrived() - position); }
+    int read() override { return position < arrived() ? (uint8_t)data[position++] : -1; }
+    int peek() override { return position < arrived() ? (uint8_t)data[position] : -1; }
+    size_t readBytes(char* buffer, size_t length) override;
+    size_t write(uint8_t c) override { return 0; }
+    size_t consumed() const { return position; }
+
+private:
+    size_t arrived();
+
+    std::string data;
+    size_t position = 0;
+    size_t segmentBytes = 0;
+    unsigned long gapMs = 0;
+    unsigned long startMs = 0;
+};
+
+class HTTPClient {
+public:
+    bool begin(const String& url);
+    // The transport is not used, responses come from FakeHttp either way
+    bool begin(WiFiClient& client, const String& url) { return begin(url); }
+    void end();
+    void useHTTP10(bool useHTTP10 = true) {}
+    void setTimeout(uint16_t timeout) { timeoutMs = timeout; }
+    void addHeader(const String& name, const String& value);
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+
+    int GET();
+    int getSize();
+    String header(const char* name);
+    Stream& getStream();
+    String getString();
+
+private:
+    uint16_t timeoutMs = 5000;
+};
+
+// Response the simulated server will send to the next requests. A latency
+// beyond the client's timeout ends in HTTPC_ERROR_READ_TIMEOUT, like a
+// server that accepts the connection but never answers. With segmentBytes
+// set the body arrives in pieces, segmentGapMs apart.
+struct FakeResponse {
+    int code;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers;
+    unsigned long latencyMs;
+    size_t segmentBytes = 0;
+    unsigned long segmentGapMs = 0;
+};
+
+// Controls the simulated API server and records what the client sent.
+// Requests go to the route whose path ends the URL, anything else gets the
+// setResponse() answer.
+class FakeHttp {
+public:
+    static void reset();
+    static void setResponse(const FakeResponse& response);
+    static void setRoute(const char* path, const FakeResponse& response);
+    static unsigned int requestCount();
+    // Requests that ended in HTTPC_ERROR_READ_TIMEOUT
+    static unsigned int timeoutCount();
+    static String lastRequestHeader(const char* name);
+    static String lastUrl();
+    // Bytes of the last response body the client read before end()
+    static size_t bodyBytesRead();
+};
+
+#endif // NATIVE_HAL_HTTPCLIENT_H
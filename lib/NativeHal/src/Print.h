@@ -0,0 +1,7 @@
+#ifndef NATIVE_HAL_PRINT_H
+#define NATIVE_HAL_PRINT_H
+
+// Print lives in Arduino.h in this HAL
+#include "Arduino.h"
+
+#endif // NATIVE_HAL_PRINT_H
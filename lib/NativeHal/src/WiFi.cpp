@@ -0,0 +1,186 @@
+#include "WiFi.h"
+
+WiFiClass WiFi;
+
+// Simulated radio state
+static std::vector<FakeAccessPoint> accessPoints;
+static std::vector<FakeAccessPoint> scanResults;
+static bool reachable = true;
+static unsigned long associateMs = 150;
+static unsigned long dhcpMs = 400;
+static unsigned long scanMsPerChannel = 120;
+static unsigned int scans = 0;
+static unsigned int dhcpRequests = 0;
+
+static wifi_mode_t currentMode = WIFI_OFF;
+static const FakeAccessPoint* connectedAp = nullptr;
+static unsigned long connectAt = 0;
+static bool connecting = false;
+static IPAddress staticIP;
+static IPAddress staticGateway;
+static IPAddress staticSubnet;
+static IPAddress staticDns;
+
+void FakeWiFi::reset() {
+    accessPoints.clear();
+    scanResults.clear();
+    reachable = true;
+    associateMs = 150;
+    dhcpMs = 400;
+    scanMsPerChannel = 120;
+    scans = 0;
+    dhcpRequests = 0;
+    WiFi.disconnect(true);
+}
+
+void FakeWiFi::addAccessPoint(const FakeAccessPoint& ap) {
+    accessPoints.push_back(ap);
+}
+
+void FakeWiFi::setReachable(bool value) {
+    reachable = value;
+}
+
+void FakeWiFi::setTimings(unsigned long associate, unsigned long dhcp, unsigned long scanPerChannel) {
+    associateMs = associate;
+    dhcpMs = dhcp;
+    scanMsPerChannel = scanPerChannel;
+}
+
+unsigned int FakeWiFi::scanCount() {
+    return scans;
+}
+
+unsigned int FakeWiFi::dhcpCount() {
+    return dhcpRequests;
+}
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+    currentMode = mode;
+    return true;
+}
+
+wifi_mode_t WiFiClass::getMode() {
+    return currentMode;
+}
+
+bool WiFiClass::config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns1) {
+    staticIP = localIP;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDns = dns1;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel,
+                             const uint8_t* bssid, bool connect) {
+    connectedAp = nullptr;
+    connecting = false;
+    if (!reachable || currentMode == WIFI_OFF) {
+        return WL_DISCONNECTED;
+    }
+
+    for (const FakeAccessPoint& ap : accessPoints) {
+        bool match = ap.ssid == ssid &&
+                     (channel == 0 || ap.channel == channel) &&
+                     (bssid == nullptr || memcmp(ap.bssid, bssid, 6) == 0);
+        if (match) {
+            connectedAp = &ap;
+            connecting = true;
+            // DHCP adds its round trip unless a static config is set
+            unsigned long duration = associateMs;
+            if ((uint32_t)staticIP == 0) {
+                duration += dhcpMs;
+                dhcpRequests++;
+            }
+            connectAt = millis() + duration;
+            break;
+        }
+    }
+    return WL_DISCONNECTED;
+}
+
+wl_status_t WiFiClass::status() {
+    if (connecting && connectedAp != nullptr && millis() >= connectAt) {
+        return WL_CONNECTED;
+    }
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp) {
+    connecting = false;
+    connectedAp = nullptr;
+    if (wifiOff) {
+        currentMode = WIFI_OFF;
+    }
+    return true;
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool showHidden, bool passive,
+                                uint32_t maxMsPerChannel, uint8_t channel) {
+    scans++;
+    scanResults.clear();
+    delay(channel == 0 ? scanMsPerChannel * 13 : scanMsPerChannel);
+    if (!reachable) {
+        return 0;
+    }
+    for (const FakeAccessPoint& ap : accessPoints) {
+        if (channel == 0 || ap.channel == channel) {
+            scanResults.push_back(ap);
+        }
+    }
+    return (int16_t)scanResults.size();
+}
+
+void WiFiClass::scanDelete() {
+    scanResults.clear();
+}
+
+String WiFiClass::SSID(uint8_t index) {
+    return index < scanResults.size() ? scanResults[index].ssid : String();
+}
+
+int32_t WiFiClass::RSSI(uint8_t index) {
+    return index < scanResults.size() ? scanResults[index].rssi : 0;
+}
+
+uint8_t* WiFiClass::BSSID(uint8_t index) {
+    return index < scanResults.size() ? scanResults[index].bssid : nullptr;
+}
+
+int32_t WiFiClass::channel(uint8_t index) {
+    return index < scanResults.size() ? scanResults[index].channel : 0;
+}
+
+uint8_t* WiFiClass::BSSID() {
+    static uint8_t none[6] = {0};
+    return status() == WL_CONNECTED ? const_cast<uint8_t*>(connectedAp->bssid) : none;
+}
+
+int32_t WiFiClass::channel() {
+    return status() == WL_CONNECTED ? connectedAp->channel : 0;
+}
+
+int8_t WiFiClass::RSSI() {
+    return status() == WL_CONNECTED ? (int8_t)connectedAp->rssi : 0;
+}
+
+IPAddress WiFiClass::localIP() {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return (uint32_t)staticIP != 0 ? staticIP : IPAddress(192, 168, 1, 50);
+}
+
+IPAddress WiFiClass::gatewayIP() {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return (uint32_t)staticIP != 0 ? staticGateway : IPAddress(192, 168, 1, 1);
+}
+
+IPAddress WiFiClass::subnetMask() {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return (uint32_t)staticIP != 0 ? staticSubnet : IPAddress(255, 255, 255, 0);
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t index) {
+    if (status() != WL_CONNECTED) return IPAddress();
+    return (uint32_t)staticIP != 0 ? staticDns : IPAddress(192, 168, 1, 1);
+}
@@ -0,0 +1,90 @@
+#ifndef NATIVE_HAL_WIFI_H
+#define NATIVE_HAL_WIFI_H
+
+#include "Arduino.h"
+#include <vector>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t mode);
+    wifi_mode_t getMode();
+    bool setSleep(wifi_ps_type_t type) { return true; }
+    bool setHostname(const char* hostname) { return true; }
+    bool config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress());
+    wl_status_t begin(const char* ssid, const char* passphrase, int32_t channel = 0,
+                      const uint8_t* bssid = nullptr, bool connect = true);
+    wl_status_t status();
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+
+    int16_t scanNetworks(bool async = false, bool showHidden = false, bool passive = false,
+                         uint32_t maxMsPerChannel = 300, uint8_t channel = 0);
+    void scanDelete();
+    String SSID(uint8_t index);
+    int32_t RSSI(uint8_t index);
+    uint8_t* BSSID(uint8_t index);
+    int32_t channel(uint8_t index);
+
+    uint8_t* BSSID();
+    int32_t channel();
+    int8_t RSSI();
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+};
+
+extern WiFiClass WiFi;
+
+// TCP client. The fake HTTPClient answers requests itself, so this never
+// connects; it exists for transports layered on top of it (TlsClient).
+class WiFiClient : public Stream {
+public:
+    virtual ~WiFiClient() {}
+    virtual int connect(IPAddress ip, uint16_t port) { return 0; }
+    virtual int connect(IPAddress ip, uint16_t port, int32_t timeout) { return 0; }
+    virtual int connect(const char* host, uint16_t port) { return 0; }
+    virtual int connect(const char* host, uint16_t port, int32_t timeout) { return 0; }
+    size_t write(uint8_t data) override { return 0; }
+    size_t write(const uint8_t* buf, size_t size) override { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    virtual int read(uint8_t* buf, size_t size) { return -1; }
+    int peek() override { return -1; }
+    virtual void flush() {}
+    virtual void stop() {}
+    virtual uint8_t connected() { return 0; }
+};
+
+// A simulated access point
+struct FakeAccessPoint {
+    String ssid;
+    uint8_t bssid[6];
+    int32_t channel;
+    int32_t rssi;
+};
+
+// Controls the simulated radio environment
+class FakeWiFi {
+public:
+    static void reset();
+    static void addAccessPoint(const FakeAccessPoint& ap);
+    static void setReachable(bool reachable);
+    static void setTimings(unsigned long associateMs, unsigned long dhcpMs, unsigned long scanMsPerChannel);
+    static unsigned int scanCount();
+    static unsigned int dhcpCount();
+};
+
+#endif // NATIVE_HAL_WIFI_H
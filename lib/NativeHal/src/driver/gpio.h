@@ -0,0 +1,23 @@
+#ifndef NATIVE_HAL_DRIVER_GPIO_H
+#define NATIVE_HAL_DRIVER_GPIO_H
+
+#include "esp_system.h"
+
+typedef int gpio_num_t;
+
+typedef enum {
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE = 1,
+    GPIO_INTR_NEGEDGE = 2,
+    GPIO_INTR_ANYEDGE = 3,
+    GPIO_INTR_LOW_LEVEL = 4,
+    GPIO_INTR_HIGH_LEVEL = 5
+} gpio_int_type_t;
+
+// Light sleep wake on a pin level (only levels work for light sleep)
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num);
+// Keeps a pin's normal configuration during light sleep
+esp_err_t gpio_sleep_sel_dis(gpio_num_t gpio_num);
+
+#endif // NATIVE_HAL_DRIVER_GPIO_H
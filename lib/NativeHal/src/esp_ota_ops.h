@@ -0,0 +1,34 @@
+#ifndef NATIVE_HAL_ESP_OTA_OPS_H
+#define NATIVE_HAL_ESP_OTA_OPS_H
+
+#include <string>
+#include "esp_partition.h"
+
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_OTA_VALIDATE_FAILED 0x1503
+#define OTA_WITH_SEQUENTIAL_WRITES (SIZE_MAX - 1)
+
+typedef uint32_t esp_ota_handle_t;
+
+const esp_partition_t* esp_ota_get_running_partition();
+const esp_partition_t* esp_ota_get_boot_partition();
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from);
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle);
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size);
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* partition);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback();
+
+// Two app slots (ota_0, ota_1) of a simulated 4 MB flash. esp_restart()
+// boots whatever the boot partition points at; the caller keeps running on
+// the host, so code after esp_restart() has to return.
+class FakeFlash {
+public:
+    static void reset(const std::string& runningImage);
+    static std::string image(const esp_partition_t* partition);
+    static unsigned int restarts();
+    static bool validated();
+};
+
+#endif // NATIVE_HAL_ESP_OTA_OPS_H
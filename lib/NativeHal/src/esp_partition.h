@@ -0,0 +1,18 @@
+#ifndef NATIVE_HAL_ESP_PARTITION_H
+#define NATIVE_HAL_ESP_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_system.h"
+
+// App partitions live in host memory (see FakeFlash in esp_ota_ops.h)
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst,
+                             size_t size);
+
+#endif // NATIVE_HAL_ESP_PARTITION_H
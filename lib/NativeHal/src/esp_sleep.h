@@ -0,0 +1,34 @@
+#ifndef NATIVE_HAL_ESP_SLEEP_H
+#define NATIVE_HAL_ESP_SLEEP_H
+
+#include <stdint.h>
+#include "esp_system.h"
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO
+} esp_sleep_wakeup_cause_t;
+typedef esp_sleep_wakeup_cause_t esp_sleep_source_t;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_gpio_wakeup();
+esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source);
+// Advances the virtual clock to the first enabled wake source: the timer,
+// or a gpio_wakeup_enable() pin reaching its level (see FakeGpio)
+esp_err_t esp_light_sleep_start();
+
+// Wake sources currently enabled, for checks of what deep sleep would use
+class FakeSleep {
+public:
+    static uint64_t timerWakeUs();
+    static bool gpioWake();
+};
+
+#endif // NATIVE_HAL_ESP_SLEEP_H
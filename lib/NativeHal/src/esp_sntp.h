@@ -0,0 +1,18 @@
+#ifndef NATIVE_HAL_ESP_SNTP_H
+#define NATIVE_HAL_ESP_SNTP_H
+
+#include <sys/time.h>
+
+typedef enum {
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS
+} sntp_sync_status_t;
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+
+sntp_sync_status_t sntp_get_sync_status();
+// Called when configTime() completes (immediately in the fake)
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+
+#endif // NATIVE_HAL_ESP_SNTP_H
@@ -0,0 +1,9 @@
+#ifndef NATIVE_HAL_ESP_TIMER_H
+#define NATIVE_HAL_ESP_TIMER_H
+
+#include <stdint.h>
+
+// Microseconds since start, on the virtual clock (see delay())
+int64_t esp_timer_get_time();
+
+#endif // NATIVE_HAL_ESP_TIMER_H
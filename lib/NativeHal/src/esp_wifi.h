@@ -0,0 +1,9 @@
+#ifndef NATIVE_HAL_ESP_WIFI_H
+#define NATIVE_HAL_ESP_WIFI_H
+
+#include <stdint.h>
+#include "esp_system.h"
+
+esp_err_t esp_wifi_set_max_tx_power(int8_t power);
+
+#endif // NATIVE_HAL_ESP_WIFI_H
@@ -0,0 +1,116 @@
+#include "AdaptiveTimeout.h"
+#include "Log.h"
+
+// Upper edges of the latency buckets (ms); longer waits count in the last
+static const uint16_t BUCKET_EDGES[LATENCY_BUCKETS] = {
+    128, 181, 256, 362, 512, 724, 1024, 1448, 2048, 2896, 4096, 5793, 8192, 11585, 16384, 23170
+};
+
+// Timeout bounds per phase (ms). The ceilings are the fixed timeouts used
+// before, the floors keep a fast network's jitter from failing a wake.
+static const struct {
+    unsigned long floorMs;
+    unsigned long ceilingMs;
+} BOUNDS[TIMEOUT_COUNT] = {
+    {1000, WIFI_FAST_CONNECT_TIMEOUT},  // TIMEOUT_ASSOCIATE
+    {3000, 20000},                      // TIMEOUT_ASSOCIATE_SCAN
+    {500, 5000},                        // TIMEOUT_NTP
+    {1500, 10000},                      // TIMEOUT_HTTP
+    {2000, 10000},                      // TIMEOUT_TLS_FULL
+    {1000, 10000},                      // TIMEOUT_TLS_RESUMED
+};
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR LatencyHistory AdaptiveTimeout::rtc_latency[TIMEOUT_COUNT] = {};
+RTC_DATA_ATTR uint8_t AdaptiveTimeout::rtc_timeouts[TIMEOUT_COUNT] = {0};
+
+unsigned long AdaptiveTimeout::get(TimeoutPhase phase) {
+    if (rtc_timeouts[phase] == 1) {
+        return ceilingMs(phase);
+    }
+    return learnedMs(phase);
+}
+
+void AdaptiveTimeout::record(TimeoutPhase phase, unsigned long ms) {
+    LatencyHistory& history = rtc_latency[phase];
+    if (samples(phase) >= TIMEOUT_MIN_SAMPLES && ms > learnedMs(phase)) {
+        LOG_INFO("%s took %lu ms, over its %lu ms timeout, relearning",
+                 phaseName(phase), ms, learnedMs(phase));
+        memset(&history, 0, sizeof(history));
+    }
+    if (samples(phase) >= LATENCY_WINDOW) {
+        for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+            history.counts[i] /= 2;
+        }
+    }
+    history.counts[bucket(ms)]++;
+    rtc_timeouts[phase] = 0;
+}
+
+void AdaptiveTimeout::recordTimeout(TimeoutPhase phase) {
+    // Counts 1..TIMEOUT_PROBE_EVERY, 1 being the probe
+    rtc_timeouts[phase] = rtc_timeouts[phase] % TIMEOUT_PROBE_EVERY + 1;
+}
+
+void AdaptiveTimeout::relearn() {
+    memset(rtc_latency, 0, sizeof(rtc_latency));
+    memset(rtc_timeouts, 0, sizeof(rtc_timeouts));
+}
+
+unsigned long AdaptiveTimeout::percentileMs(TimeoutPhase phase) {
+    uint8_t total = samples(phase);
+    if (total < TIMEOUT_MIN_SAMPLES) {
+        return 0;
+    }
+    // Smallest bucket with 95% of the samples at or below it
+    unsigned needed = ((unsigned)total * 95 + 99) / 100;
+    unsigned seen = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += rtc_latency[phase].counts[i];
+        if (seen >= needed) {
+            return BUCKET_EDGES[i];
+        }
+    }
+    return BUCKET_EDGES[LATENCY_BUCKETS - 1];
+}
+
+uint8_t AdaptiveTimeout::samples(TimeoutPhase phase) {
+    unsigned total = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+        total += rtc_latency[phase].counts[i];
+    }
+    return (uint8_t)min(total, (unsigned)UINT8_MAX);
+}
+
+unsigned long AdaptiveTimeout::ceilingMs(TimeoutPhase phase) {
+    return BOUNDS[phase].ceilingMs;
+}
+
+const char* AdaptiveTimeout::phaseName(TimeoutPhase phase) {
+    switch (phase) {
+        case TIMEOUT_ASSOCIATE: return "association";
+        case TIMEOUT_ASSOCIATE_SCAN: return "association after scan";
+        case TIMEOUT_NTP: return "NTP";
+        case TIMEOUT_HTTP: return "HTTP";
+        case TIMEOUT_TLS_FULL: return "TLS handshake";
+        case TIMEOUT_TLS_RESUMED: return "TLS resumption";
+        default: return "?";
+    }
+}
+
+unsigned long AdaptiveTimeout::learnedMs(TimeoutPhase phase) {
+    unsigned long percentile = percentileMs(phase);
+    if (!ADAPTIVE_TIMEOUTS || percentile == 0) {
+        return ceilingMs(phase);
+    }
+    unsigned long timeoutMs = percentile * TIMEOUT_MARGIN_PERCENT / 100;
+    return constrain(timeoutMs, BOUNDS[phase].floorMs, BOUNDS[phase].ceilingMs);
+}
+
+uint8_t AdaptiveTimeout::bucket(unsigned long ms) {
+    uint8_t i = 0;
+    while (i < LATENCY_BUCKETS - 1 && ms > BUCKET_EDGES[i]) {
+        i++;
+    }
+    return i;
+}
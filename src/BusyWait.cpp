@@ -0,0 +1,88 @@
+#include "BusyWait.h"
+#include "Log.h"
+#include <WiFi.h>
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+
+bool BusyWait::active = false;
+bool BusyWait::lightSleep = false;
+BusyStats BusyWait::current = {};
+uint64_t BusyWait::sleepTimerUs = 0;
+
+void BusyWait::begin(bool sleep) {
+    current = {};
+    active = true;
+    lightSleep = sleep;
+    if (lightSleep) {
+        // Outputs must hold their level while asleep: panel power, reset
+        // and chip select
+        gpio_sleep_sel_dis((gpio_num_t)EPD_POWER_PIN);
+        gpio_sleep_sel_dis((gpio_num_t)EPD_RST);
+        gpio_sleep_sel_dis((gpio_num_t)EPD_CS);
+    }
+}
+
+void BusyWait::setSleepTimer(uint64_t us) {
+    sleepTimerUs = us;
+    esp_sleep_enable_timer_wakeup(us);
+}
+
+void BusyWait::end(const char* label) {
+    active = false;
+    if (current.busyMs == 0) {
+        return;
+    }
+    LOG_INFO("BUSY %s: %lu ms, %lu ms in light sleep (%u wakes), ~%lu uAs vs %lu uAs polling",
+             label, (unsigned long)current.busyMs, (unsigned long)current.sleepMs,
+             (unsigned)current.sleeps, (unsigned long)(chargeUaMs() / 1000),
+             (unsigned long)(pollingChargeUaMs() / 1000));
+}
+
+void BusyWait::callback(const void* context) {
+    int64_t startUs = esp_timer_get_time();
+
+    // The radio can't be kept up in light sleep; the USB console drops too
+    if (!active || !lightSleep || WiFi.getMode() != WIFI_OFF) {
+        delay(1);
+    } else {
+        // Wake on the level BUSY changes to (light sleep only knows levels)
+        gpio_int_type_t level = digitalRead(EPD_BUSY) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL;
+        gpio_wakeup_enable((gpio_num_t)EPD_BUSY, level);
+        esp_sleep_enable_gpio_wakeup();
+        esp_sleep_enable_timer_wakeup((uint64_t)BUSY_WAKE_INTERVAL_MS * 1000);
+        bool slept = esp_light_sleep_start() == ESP_OK;
+        // Put the wake sources back as found: GPIO wake is only ours, the
+        // timer may carry the deep-sleep interval (IDF has no getter for it)
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+        gpio_wakeup_disable((gpio_num_t)EPD_BUSY);
+        if (sleepTimerUs > 0) {
+            esp_sleep_enable_timer_wakeup(sleepTimerUs);
+        } else {
+            esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+        }
+        if (slept) {
+            current.sleepMs += (uint32_t)((esp_timer_get_time() - startUs) / 1000);
+            current.sleeps++;
+        } else {
+            delay(1);
+        }
+    }
+
+    if (active) {
+        current.busyMs += (uint32_t)((esp_timer_get_time() - startUs) / 1000);
+    }
+}
+
+const BusyStats& BusyWait::stats() {
+    return current;
+}
+
+uint64_t BusyWait::chargeUaMs() {
+    return (uint64_t)current.sleepMs * BUSY_SLEEP_CURRENT_UA +
+           (uint64_t)(current.busyMs - current.sleepMs) * BUSY_POLL_CURRENT_UA;
+}
+
+uint64_t BusyWait::pollingChargeUaMs() {
+    return (uint64_t)current.busyMs * BUSY_POLL_CURRENT_UA;
+}
@@ -0,0 +1,111 @@
+#include "CircuitBreaker.h"
+#include "Log.h"
+
+// A phase isn't started with less than this left of the wake budget (ms)
+#define MIN_PHASE_MS 1000
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR uint8_t CircuitBreaker::rtc_ntpFailures = 0;
+RTC_DATA_ATTR uint8_t CircuitBreaker::rtc_ntpSkipped = 0;
+RTC_DATA_ATTR uint16_t CircuitBreaker::rtc_failedWakes = 0;
+
+unsigned long CircuitBreaker::wakeStartMs = 0;
+
+void CircuitBreaker::beginWake() {
+    wakeStartMs = millis();
+
+    if (rtc_failedWakes > 0) {
+        LOG_WARN("Previous %u wake(s) failed to fetch data", rtc_failedWakes);
+    }
+}
+
+bool CircuitBreaker::allow(BreakerPhase phase) {
+    if (remainingMs() < MIN_PHASE_MS) {
+        LOG_WARN("Wake time budget used up, skipping %s (phase %u)", phaseName(phase), phase);
+        return false;
+    }
+
+    if (!isOpen(phase)) {
+        return true;
+    }
+
+    // WiFi and HTTP: the wake backoff already spaces the attempts, so each
+    // wake that gets here is the probe
+    if (phase != BREAKER_NTP) {
+        LOG_INFO("Probing %s after %u failed wakes", phaseName(phase), rtc_failedWakes);
+        return true;
+    }
+
+    // Breaker open: only let a probe through every BREAKER_PROBE_EVERY wakes
+    if (++rtc_ntpSkipped >= BREAKER_PROBE_EVERY) {
+        rtc_ntpSkipped = 0;
+        LOG_INFO("Probing %s after repeated failures", phaseName(phase));
+        return true;
+    }
+
+    LOG_WARN("Skipping %s (%u consecutive failures)", phaseName(phase), rtc_ntpFailures);
+    return false;
+}
+
+bool CircuitBreaker::isOpen(BreakerPhase phase) {
+    // A wake still works without NTP (the RTC clock carries on), so it
+    // counts its own failures; WiFi and HTTP fail the wake
+    if (phase == BREAKER_NTP) {
+        return rtc_ntpFailures >= BREAKER_FAILURE_LIMIT;
+    }
+    return rtc_failedWakes >= BREAKER_FAILURE_LIMIT;
+}
+
+void CircuitBreaker::recordNtp(bool synced) {
+    if (synced) {
+        rtc_ntpFailures = 0;
+        rtc_ntpSkipped = 0;
+    } else if (rtc_ntpFailures < UINT8_MAX) {
+        rtc_ntpFailures++;
+    }
+}
+
+void CircuitBreaker::recordWake(bool fetched) {
+    if (fetched) {
+        rtc_failedWakes = 0;
+    } else if (rtc_failedWakes < UINT16_MAX) {
+        rtc_failedWakes++;
+    }
+}
+
+unsigned long CircuitBreaker::remainingMs() {
+    unsigned long elapsed = millis() - wakeStartMs;
+    return elapsed >= WAKE_TIME_BUDGET ? 0 : WAKE_TIME_BUDGET - elapsed;
+}
+
+unsigned long CircuitBreaker::limitTimeout(unsigned long timeoutMs) {
+    return min(timeoutMs, remainingMs());
+}
+
+uint32_t CircuitBreaker::backoffSeconds(uint32_t baseSeconds) {
+    if (rtc_failedWakes == 0) {
+        return baseSeconds;
+    }
+
+    // Retry at the base interval once, then double per failed wake
+    uint64_t seconds = (uint64_t)baseSeconds << min(rtc_failedWakes - 1, 16);
+    uint64_t maxSeconds = max((uint64_t)(MAX_BACKOFF_INTERVAL / 1000), (uint64_t)baseSeconds);
+    return (uint32_t)min(seconds, maxSeconds);
+}
+
+uint16_t CircuitBreaker::failedWakes() {
+    return rtc_failedWakes;
+}
+
+bool CircuitBreaker::showOffline() {
+    return rtc_failedWakes >= OFFLINE_REDRAW_AFTER;
+}
+
+const char* CircuitBreaker::phaseName(BreakerPhase phase) {
+    switch (phase) {
+        case BREAKER_WIFI: return "WiFi";
+        case BREAKER_NTP: return "NTP";
+        case BREAKER_HTTP: return "HTTP";
+        default: return "?";
+    }
+}
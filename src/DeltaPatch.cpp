@@ -0,0 +1,254 @@
+#include "DeltaPatch.h"
+
+// Fixed part of a copy and of an edit
+#define COPY_FIELDS_SIZE 10
+#define EDIT_FIELDS_SIZE 3
+
+DeltaPatch::DeltaPatch(ReadOld readOld, WriteNew writeNew, void* context)
+    : readOld(readOld), writeNew(writeNew), context(context), state(STATE_HEADER),
+      failure(nullptr), header{0, 0, 0, 0}, fieldLength(0), source(0), copyLeft(0),
+      editsLeft(0), bytesLeft(0), produced(0), crc(0), buffered(0) {}
+
+DeltaPatch::Result DeltaPatch::feed(const uint8_t* bytes, size_t size) {
+    while (state != STATE_DONE && state != STATE_FAILED && step(bytes, size)) {
+    }
+    if (state == STATE_DONE && size > 0) {
+        fail("data after the end of the patch");
+    }
+    if (state == STATE_FAILED) {
+        return PATCH_ERROR;
+    }
+    return state == STATE_DONE ? PATCH_DONE : PATCH_MORE;
+}
+
+bool DeltaPatch::step(const uint8_t*& bytes, size_t& size) {
+    switch (state) {
+        case STATE_HEADER:
+            if (!collect(bytes, size, DELTA_HEADER_SIZE)) {
+                return false;
+            }
+            if (memcmp(field, DELTA_MAGIC, 4) != 0) {
+                return fail("not a delta patch");
+            }
+            header = {readU32(field + 4), readU32(field + 8), readU32(field + 12), readU32(field + 16)};
+            if (!checkBase()) {
+                return false;
+            }
+            state = STATE_OP;
+            return true;
+
+        case STATE_OP: {
+            if (size == 0) {
+                return false;
+            }
+            uint8_t op = *bytes++;
+            size--;
+            if (op == DELTA_OP_COPY) {
+                state = STATE_COPY;
+            } else if (op == DELTA_OP_INSERT) {
+                state = STATE_INSERT;
+            } else if (op == DELTA_OP_END) {
+                return finish();
+            } else {
+                return fail("unknown patch operation");
+            }
+            return true;
+        }
+
+        case STATE_COPY:
+            return collect(bytes, size, COPY_FIELDS_SIZE) && startCopy();
+
+        case STATE_EDIT:
+            return collect(bytes, size, EDIT_FIELDS_SIZE) && startEdit();
+
+        case STATE_INSERT:
+            if (!collect(bytes, size, 4)) {
+                return false;
+            }
+            bytesLeft = readU32(field);
+            state = bytesLeft > 0 ? STATE_INSERT_BYTES : STATE_OP;
+            return true;
+
+        case STATE_EDIT_BYTES:
+        case STATE_INSERT_BYTES: {
+            if (size == 0) {
+                return false;
+            }
+            size_t n = min((size_t)bytesLeft, size);
+            if (!emit(bytes, n)) {
+                return false;
+            }
+            bytes += n;
+            size -= n;
+            bytesLeft -= n;
+            if (state == STATE_EDIT_BYTES) {
+                // Edited bytes take the place of old ones
+                source += n;
+                copyLeft -= n;
+            }
+            if (bytesLeft > 0) {
+                return true;
+            }
+            if (state == STATE_INSERT_BYTES) {
+                state = STATE_OP;
+                return true;
+            }
+            if (editsLeft > 0) {
+                state = STATE_EDIT;
+                return true;
+            }
+            state = STATE_OP;
+            return copyOld(copyLeft);
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool DeltaPatch::collect(const uint8_t*& bytes, size_t& size, size_t needed) {
+    size_t n = min(needed - fieldLength, size);
+    memcpy(field + fieldLength, bytes, n);
+    fieldLength += n;
+    bytes += n;
+    size -= n;
+    if (fieldLength < needed) {
+        return false;
+    }
+    fieldLength = 0;
+    return true;
+}
+
+bool DeltaPatch::startCopy() {
+    source = readU32(field);
+    copyLeft = readU32(field + 4);
+    editsLeft = readU16(field + 8);
+    if (source > header.oldSize || copyLeft > header.oldSize - source) {
+        return fail("copy outside the old image");
+    }
+    if (editsLeft > 0) {
+        state = STATE_EDIT;
+        return true;
+    }
+    state = STATE_OP;
+    return copyOld(copyLeft);
+}
+
+bool DeltaPatch::startEdit() {
+    uint16_t skip = readU16(field);
+    uint8_t count = field[2];
+    editsLeft--;
+    if ((uint32_t)skip + count > copyLeft) {
+        return fail("edit outside its copy");
+    }
+    if (!copyOld(skip)) {
+        return false;
+    }
+    bytesLeft = count;
+    if (count > 0) {
+        state = STATE_EDIT_BYTES;
+        return true;
+    }
+    // Nothing to replace, only a skip
+    if (editsLeft > 0) {
+        return true;
+    }
+    state = STATE_OP;
+    return copyOld(copyLeft);
+}
+
+bool DeltaPatch::checkBase() {
+    // Applying a patch to a different image would produce garbage, so the
+    // running image is verified before anything is written
+    uint32_t baseCrc = 0;
+    for (uint32_t offset = 0; offset < header.oldSize; offset += DELTA_BUFFER_SIZE) {
+        size_t n = min((uint32_t)DELTA_BUFFER_SIZE, header.oldSize - offset);
+        if (!readOld(context, offset, buffer, n)) {
+            return fail("reading the old image failed");
+        }
+        baseCrc = crc32(baseCrc, buffer, n);
+    }
+    if (baseCrc != header.oldCrc) {
+        return fail("patch is for a different image");
+    }
+    return true;
+}
+
+bool DeltaPatch::copyOld(uint32_t length) {
+    if (length > header.newSize - produced) {
+        return fail("patch exceeds the new image size");
+    }
+    while (length > 0) {
+        size_t n = min((size_t)length, DELTA_BUFFER_SIZE - buffered);
+        if (!readOld(context, source, buffer + buffered, n)) {
+            return fail("reading the old image failed");
+        }
+        buffered += n;
+        source += n;
+        copyLeft -= n;
+        length -= n;
+        produced += n;
+        if (buffered == DELTA_BUFFER_SIZE && !flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DeltaPatch::emit(const uint8_t* bytes, size_t size) {
+    if (size > header.newSize - produced) {
+        return fail("patch exceeds the new image size");
+    }
+    while (size > 0) {
+        size_t n = min(size, DELTA_BUFFER_SIZE - buffered);
+        memcpy(buffer + buffered, bytes, n);
+        buffered += n;
+        bytes += n;
+        size -= n;
+        produced += n;
+        if (buffered == DELTA_BUFFER_SIZE && !flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DeltaPatch::flush() {
+    if (buffered == 0) {
+        return true;
+    }
+    crc = crc32(crc, buffer, buffered);
+    if (!writeNew(context, buffer, buffered)) {
+        return fail("writing the new image failed");
+    }
+    buffered = 0;
+    return true;
+}
+
+bool DeltaPatch::finish() {
+    if (!flush()) {
+        return false;
+    }
+    if (produced != header.newSize) {
+        return fail("new image incomplete");
+    }
+    if (crc != header.newCrc) {
+        return fail("new image CRC mismatch");
+    }
+    state = STATE_DONE;
+    return true;
+}
+
+bool DeltaPatch::fail(const char* reason) {
+    failure = reason;
+    state = STATE_FAILED;
+    return false;
+}
+
+uint32_t DeltaPatch::readU32(const uint8_t* bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+uint16_t DeltaPatch::readU16(const uint8_t* bytes) {
+    return bytes[0] | (bytes[1] << 8);
+}
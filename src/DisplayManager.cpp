@@ -1,34 +1,58 @@
 #include "DisplayManager.h"
+#include "BusyWait.h"
+#include "Log.h"
 #include <SPI.h>
 
-// Layout constants for display positioning
-#define MARGIN_LEFT 10
-#define MARGIN_RIGHT 20
-#define MARGIN_TOP 10
-#define MARGIN_BOTTOM 10
-#define TITLE_Y 25
-#define MAIN_TEXT_Y 80
-#define SUBTITLE_Y 105
-#define DETAIL_Y 120
-#define DIVIDER_X 200
-#define DIVIDER_END_Y 140
-#define PROGRESS_BAR_Y 150
-#define PROGRESS_BAR_HEIGHT 25
-#define DATE_Y 196
-#define ERROR_ICON_SIZE 12
-#define ERROR_ICON_MARGIN 25
-
-// Initialize display instance
-static GxEPD2_BW<GxEPD2_370_GDEY037T03, GxEPD2_370_GDEY037T03::HEIGHT> display(
-    GxEPD2_370_GDEY037T03(EPD_CS, EPD_DC, EPD_RST, EPD_BUSY)
+// Initialize static RTC memory variables
+RTC_DATA_ATTR FrameSignature DisplayState::rtc_lastFrame = {};
+RTC_DATA_ATTR uint8_t DisplayState::rtc_partialCount = 0;
+RTC_DATA_ATTR bool DisplayState::rtc_hasFrame = false;
+
+bool DisplayState::initialized = false;
+SemaphoreHandle_t DisplayState::initDone = nullptr;
+
+// Initialize display instance (framebuffer sized by pageHeight)
+template <typename Panel, const DisplayLayout& Layout>
+typename PanelDisplay<Panel, Layout>::Display PanelDisplay<Panel, Layout>::display(
+    Panel(EPD_CS, EPD_DC, EPD_RST, EPD_BUSY)
 );
 
-GxEPD2_BW<GxEPD2_370_GDEY037T03, GxEPD2_370_GDEY037T03::HEIGHT>& DisplayManager::getDisplay() {
-    return display;
+template <typename Panel, const DisplayLayout& Layout>
+void PanelDisplay<Panel, Layout>::beginInit() {
+    if (initialized || initDone != nullptr) {
+        return;
+    }
+
+    // Power-up and SPI init run in their own task so the power settle
+    // overlaps with whatever the main task is waiting on (WiFi, HTTP)
+    initDone = xSemaphoreCreateBinary();
+    xTaskCreate(initTask, "display_init", 4096, nullptr, 1, nullptr);
+}
+
+template <typename Panel, const DisplayLayout& Layout>
+void PanelDisplay<Panel, Layout>::initTask(void* param) {
+    powerUp();
+    xSemaphoreGive(initDone);
+    vTaskDelete(nullptr);
+}
+
+template <typename Panel, const DisplayLayout& Layout>
+void PanelDisplay<Panel, Layout>::init() {
+    if (initDone != nullptr) {
+        // Background init was started, wait for it to finish
+        xSemaphoreTake(initDone, portMAX_DELAY);
+        vSemaphoreDelete(initDone);
+        initDone = nullptr;
+    }
+    if (!initialized) {
+        powerUp();
+    }
 }
 
-void DisplayManager::init() {
-    Serial.println("Initializing display...");
+template <typename Panel, const DisplayLayout& Layout>
+void PanelDisplay<Panel, Layout>::powerUp() {
+    LOG_DEBUG("Initializing display...");
+    WakeProfiler::start(PHASE_DISPLAY_INIT);
 
     // Enable display power (GPIO8 must be HIGH)
     pinMode(EPD_POWER_PIN, OUTPUT);
@@ -38,127 +62,83 @@ void DisplayManager::init() {
     // Initialize SPI with custom pins
     SPI.begin(EPD_SCK, -1, EPD_MOSI, EPD_CS);
 
-    // Initialize display
-    display.init(115200, true, 50, false);
+    // Initialize display (initial=false allows the first update to be partial
+    // when the panel still shows our last frame)
+    display.init(115200, !(PARTIAL_REFRESH && rtc_hasFrame), 50, false);
+    display.epd2.setBusyCallback(BusyWait::callback);
     display.setRotation(DISPLAY_ROTATION);
     display.setTextColor(GxEPD_BLACK);
-
-    Serial.print("Display initialized: ");
-    Serial.print(display.width());
-    Serial.print("x");
-    Serial.println(display.height());
+    initialized = true;
+    WakeProfiler::stop(PHASE_DISPLAY_INIT);
+
+    if (pageHeight<Panel>() < Panel::HEIGHT) {
+        LOG_DEBUG("Display initialized: %dx%d, paged (%u rows)",
+                  display.width(), display.height(), (unsigned)pageHeight<Panel>());
+    } else {
+        LOG_DEBUG("Display initialized: %dx%d", display.width(), display.height());
+    }
 }
 
-void DisplayManager::drawErrorIcon() {
-    // Draw a small "X" icon in circle to indicate error (top right)
-    int iconX = display.width() - ERROR_ICON_MARGIN;
-    int iconY = MARGIN_TOP;
-    display.drawLine(iconX, iconY, iconX + 10, iconY + 10, GxEPD_BLACK);
-    display.drawLine(iconX + 10, iconY, iconX, iconY + 10, GxEPD_BLACK);
-    display.drawCircle(iconX + 5, iconY + 5, ERROR_ICON_SIZE, GxEPD_BLACK);
+template <typename Panel, const DisplayLayout& Layout>
+bool PanelDisplay<Panel, Layout>::needsRedraw(const GoalData& data) {
+    // Compares against the last drawn frame without touching the panel,
+    // so this is safe to call before init()
+    if (!rtc_hasFrame) {
+        return true;
+    }
+    FrameSignature frame = GoalRenderer::makeSignature<Layout>(data);
+    return GoalRenderer::dirtyRegions(rtc_lastFrame, frame) != 0;
 }
 
-
-void DisplayManager::showGoalInfo(const GoalData& data) {
-    display.setFullWindow();
-    display.firstPage();
-
-    do {
-        display.fillScreen(GxEPD_WHITE);
-
-        // Title at top left
-        display.setFont(&FreeMonoBold12pt7b);
-        display.setCursor(MARGIN_LEFT, TITLE_Y);
-        display.print("DAYS TO GOAL");
-
-        // Error/offline indicator - top right
-        if (!data.lastUpdateSuccess) {
-            drawErrorIcon();
-        }
-
-        // Left side - Days remaining
-        display.setFont(&FreeMonoBold24pt7b);
-        display.setCursor(MARGIN_LEFT, MAIN_TEXT_Y);
-        display.print(data.daysToGoal);
-
-        display.setFont(&FreeMonoBold12pt7b);
-        display.setCursor(MARGIN_LEFT, SUBTITLE_Y);
-        display.print("DAYS LEFT");
-
-        // Calculate years from days
-        int years = data.daysToGoal / 365;
-        int months = (data.daysToGoal % 365) / 30;
-
-        display.setFont();
-        display.setCursor(MARGIN_LEFT, DETAIL_Y);
-        display.print("~");
-        display.print(years);
-        display.print("y ");
-        display.print(months);
-        display.print("m");
-
-        // Vertical divider line (stops before progress bar)
-        display.drawLine(DIVIDER_X, MARGIN_TOP, DIVIDER_X, DIVIDER_END_Y, GxEPD_BLACK);
-
-        // Right side - Progress percentage
-        display.setFont(&FreeMonoBold24pt7b);
-        display.setCursor(DIVIDER_X + 20, MAIN_TEXT_Y);
-        display.print(data.progressPercent, 1);
-        display.print("%");
-
-        display.setFont(&FreeMonoBold12pt7b);
-        display.setCursor(DIVIDER_X + 20, SUBTITLE_Y);
-        display.print("COMPLETE");
-
-        // Progress bar - horizontal at bottom
-        int barX = MARGIN_LEFT;
-        int barY = PROGRESS_BAR_Y;
-        int barWidth = display.width() - MARGIN_LEFT - MARGIN_RIGHT;
-        int barHeight = PROGRESS_BAR_HEIGHT;
-
-        // Draw outline
-        display.drawRect(barX, barY, barWidth, barHeight, GxEPD_BLACK);
-
-        // Fill progress (with bounds checking)
-        int fillWidth = (int)((data.progressPercent / 100.0) * (barWidth - 4));
-        // Ensure fillWidth doesn't exceed bar bounds
-        if (fillWidth > barWidth - 4) {
-            fillWidth = barWidth - 4;
-        }
-        if (fillWidth > 0) {
-            display.fillRect(barX + 2, barY + 2, fillWidth, barHeight - 4, GxEPD_BLACK);
-        }
-
-        // Target date display - centered below progress bar
-        display.setFont(&FreeMonoBold12pt7b);
-        int16_t x1, y1;
-        uint16_t w, h;
-        display.getTextBounds(data.targetDate, 0, 0, &x1, &y1, &w, &h);
-        int dateX = (display.width() - w) / 2;
-        display.setCursor(dateX, DATE_Y);
-        display.print(data.targetDate);
-
-        // Bottom info
-        display.setFont();
-
-        // Left: Last update time
-        display.setCursor(MARGIN_LEFT, display.height() - MARGIN_BOTTOM);
-        if (data.lastUpdateSuccess) {
-            display.print("Updated: ");
-            display.print(data.lastUpdateTime);
-        } else {
-            display.print("Last: ");
-            display.print(data.lastUpdateTime);
-            display.print(" (offline)");
+template <typename Panel, const DisplayLayout& Layout>
+void PanelDisplay<Panel, Layout>::showGoalInfo(const GoalData& data) {
+    WakeProfiler::start(PHASE_RENDER);
+    FrameSignature frame = GoalRenderer::makeSignature<Layout>(data);
+
+    bool fullRefresh = !PARTIAL_REFRESH || !rtc_hasFrame ||
+                       rtc_partialCount >= FULL_REFRESH_EVERY;
+
+    if (fullRefresh) {
+        display.setFullWindow();
+        BusyWait::begin();
+        display.firstPage();
+        do {
+            GoalRenderer::draw<Layout>(display, data);
+        } while (display.nextPage());
+        BusyWait::end("full refresh");
+
+        rtc_partialCount = 0;
+        LOG_INFO("Display updated (full refresh)");
+    } else {
+        uint8_t dirty = GoalRenderer::dirtyRegions(rtc_lastFrame, frame);
+        if (dirty == 0) {
+            WakeProfiler::stop(PHASE_RENDER);
+            LOG_INFO("Display unchanged, skipping refresh");
+            return;
         }
 
-    } while (display.nextPage());
-
-    Serial.println("Display updated");
+        GoalRenderer::Rect window = GoalRenderer::dirtyBounds<Layout>(dirty);
+        display.setPartialWindow(window.x, window.y, window.w, window.h);
+        BusyWait::begin();
+        display.firstPage();
+        do {
+            GoalRenderer::draw<Layout>(display, data);
+        } while (display.nextPage());
+        BusyWait::end("partial refresh");
+
+        rtc_partialCount++;
+        LOG_INFO("Display updated (partial refresh, regions 0x%X)", dirty);
+    }
+
+    rtc_lastFrame = frame;
+    rtc_hasFrame = true;
+    WakeProfiler::stop(PHASE_RENDER);
 }
 
-void DisplayManager::showError(const char* message) {
+template <typename Panel, const DisplayLayout& Layout>
+void PanelDisplay<Panel, Layout>::showError(const char* message) {
     display.setFullWindow();
+    BusyWait::begin();
     display.firstPage();
 
     do {
@@ -169,17 +149,39 @@ void DisplayManager::showError(const char* message) {
         display.setCursor(20, 140);
         display.print(message);
     } while (display.nextPage());
+    BusyWait::end("error screen");
 
-    Serial.print("Error displayed: ");
-    Serial.println(message);
+    // Panel no longer shows a goal frame, next update must be a full refresh
+    rtc_hasFrame = false;
+
+    LOG_WARN("Error displayed: %s", message);
 }
 
-void DisplayManager::hibernate() {
+template <typename Panel, const DisplayLayout& Layout>
+void PanelDisplay<Panel, Layout>::hibernate() {
+    // Don't cut power under a background init that is still running
+    if (initDone != nullptr) {
+        init();
+    }
+
+    // Nothing to do if the panel was never powered up this wake
+    if (!initialized) {
+        return;
+    }
+
+    WakeProfiler::start(PHASE_HIBERNATE);
+    BusyWait::begin();
     display.hibernate();
+    BusyWait::end("power off");
 
     // Turn off display power to save energy during deep sleep
     digitalWrite(EPD_POWER_PIN, LOW);
     pinMode(EPD_POWER_PIN, INPUT);  // Set to high impedance
 
-    Serial.println("Display hibernated and powered off");
+    initialized = false;
+    WakeProfiler::stop(PHASE_HIBERNATE);
+
+    LOG_DEBUG("Display hibernated and powered off");
 }
+
+template class PanelDisplay<DISPLAY_PANEL, DISPLAY_LAYOUT>;
@@ -1,43 +1,148 @@
 #include "GoalData.h"
+#include "Log.h"
+#include "TimeKeeper.h"
+#include "Crc32.h"
+
+#define FLAG_LAST_UPDATE_SUCCESS 0x01
 
 // Initialize static RTC memory variables
-RTC_DATA_ATTR int DataStorage::rtc_daysToGoal = 0;
-RTC_DATA_ATTR float DataStorage::rtc_progressPercent = 0.0;
-RTC_DATA_ATTR char DataStorage::rtc_lastUpdateTime[20] = "";
-RTC_DATA_ATTR char DataStorage::rtc_targetDate[30] = "";
-RTC_DATA_ATTR bool DataStorage::rtc_lastUpdateSuccess = false;
-RTC_DATA_ATTR bool DataStorage::rtc_hasData = false;
-
-void DataStorage::save(const GoalData& data) {
-    rtc_daysToGoal = data.daysToGoal;
-    rtc_progressPercent = data.progressPercent;
-    strncpy(rtc_lastUpdateTime, data.lastUpdateTime.c_str(), 19);
-    rtc_lastUpdateTime[19] = '\0';
-    strncpy(rtc_targetDate, data.targetDate.c_str(), 29);
-    rtc_targetDate[29] = '\0';
-    rtc_lastUpdateSuccess = data.lastUpdateSuccess;
-    rtc_hasData = true;
-
-    Serial.println("Data saved to RTC memory");
-}
-
-bool DataStorage::load(GoalData& data) {
-    if (!rtc_hasData) {
-        Serial.println("No cached data in RTC memory");
+RTC_DATA_ATTR GoalRecord DataStorage::rtc_records[GOAL_COUNT] = {};
+RTC_DATA_ATTR uint8_t DataStorage::rtc_goalCount = 0;
+RTC_DATA_ATTR uint8_t DataStorage::rtc_page = 0;
+
+void DataStorage::save(const GoalData& data, uint8_t index) {
+    if (index >= GOAL_COUNT) {
+        return;
+    }
+    GoalRecord& record = rtc_records[index];
+
+    // Keep the trend history of a valid record of the same goal, start over
+    // otherwise (the server may reorder or replace goals)
+    if (!isValid(record) || strncmp(record.name, data.name, GOAL_NAME_SIZE - 1) != 0) {
+        memset(&record, 0, sizeof(record));
+    }
+
+    uint16_t progressCenti = (uint16_t)constrain(lroundf(data.progressPercent * 100.0f), 0L, 65535L);
+
+    record.version = GOAL_RECORD_VERSION;
+    record.flags = data.lastUpdateSuccess ? FLAG_LAST_UPDATE_SUCCESS : 0;
+    record.daysToGoal = data.daysToGoal;
+    record.progressCenti = progressCenti;
+    record.dataEpoch = (uint32_t)data.dataTime;
+    record.fetchEpoch = TimeKeeper::isTimeValid() ? (uint32_t)time(nullptr) : 0;
+    strncpy(record.name, data.name, GOAL_NAME_SIZE - 1);
+    record.name[GOAL_NAME_SIZE - 1] = '\0';
+
+    // One sample per day, dated by the data itself when we know its time
+    uint32_t sampleEpoch = record.dataEpoch ? record.dataEpoch : record.fetchEpoch;
+    if (sampleEpoch != 0) {
+        addTrendSample(record, (uint16_t)(sampleEpoch / 86400), progressCenti);
+    }
+
+    record.crc = checksum(record);
+    if (rtc_goalCount <= index) {
+        rtc_goalCount = index + 1;
+    }
+
+    LOG_DEBUG("Data saved to RTC memory (goal %u)", index + 1);
+}
+
+bool DataStorage::load(GoalData& data, uint8_t index) {
+    if (!hasData() || index >= rtc_goalCount) {
+        LOG_INFO("No cached data in RTC memory");
         return false;
     }
+    const GoalRecord& record = rtc_records[index];
 
-    data.daysToGoal = rtc_daysToGoal;
-    data.progressPercent = rtc_progressPercent;
-    data.lastUpdateTime = String(rtc_lastUpdateTime);
-    data.targetDate = String(rtc_targetDate);
-    data.lastUpdateSuccess = rtc_lastUpdateSuccess;
+    data.daysToGoal = record.daysToGoal;
+    if (record.fetchEpoch != 0 && record.daysToGoal > 0 && TimeKeeper::isTimeValid()) {
+        // Count down by the local days since the fetch, so wakes without one
+        // still show today's number (the target date below doesn't move)
+        int32_t elapsed = TimeKeeper::localDay(time(nullptr)) - TimeKeeper::localDay(record.fetchEpoch);
+        data.daysToGoal = max(record.daysToGoal - max(elapsed, (int32_t)0), (int32_t)0);
+    }
+    data.progressPercent = record.progressCenti / 100.0f;
+    data.dataTime = record.dataEpoch;
+    data.targetTime = record.fetchEpoch ? record.fetchEpoch + (time_t)record.daysToGoal * 86400 : 0;
+    data.lastUpdateSuccess = record.flags & FLAG_LAST_UPDATE_SUCCESS;
+    strncpy(data.name, record.name, GOAL_NAME_SIZE - 1);
+    data.name[GOAL_NAME_SIZE - 1] = '\0';
+    data.page = index;
+    data.pageCount = rtc_goalCount;
     data.isValid = true;
 
-    Serial.println("Data loaded from RTC memory");
+    // Unroll the ring, oldest sample first
+    uint8_t oldest = (record.trendHead + TREND_HISTORY_DAYS - record.trendCount) % TREND_HISTORY_DAYS;
+    for (uint8_t i = 0; i < record.trendCount; i++) {
+        data.trend[i] = record.trend[(oldest + i) % TREND_HISTORY_DAYS];
+    }
+    data.trendCount = record.trendCount;
+
+    LOG_DEBUG("Data loaded from RTC memory");
     return true;
 }
 
 bool DataStorage::hasData() {
-    return rtc_hasData;
+    if (rtc_goalCount == 0 || rtc_goalCount > GOAL_COUNT) {
+        return false;
+    }
+    for (uint8_t i = 0; i < rtc_goalCount; i++) {
+        if (!isValid(rtc_records[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DataStorage::setGoalCount(uint8_t count) {
+    rtc_goalCount = min(count, GOAL_COUNT);
+    if (rtc_page >= rtc_goalCount) {
+        rtc_page = 0;
+    }
+}
+
+uint8_t DataStorage::goalCount() {
+    return hasData() ? rtc_goalCount : 0;
+}
+
+uint8_t DataStorage::currentPage() {
+    return rtc_page < rtc_goalCount ? rtc_page : 0;
+}
+
+uint8_t DataStorage::nextPage() {
+    if (rtc_goalCount > 1) {
+        rtc_page = (currentPage() + 1) % rtc_goalCount;
+    }
+    return currentPage();
+}
+
+bool DataStorage::isValid(const GoalRecord& record) {
+    // Catches cold boots (all zero), records of another firmware version and
+    // corrupted RTC memory
+    return record.version == GOAL_RECORD_VERSION &&
+           record.trendCount <= TREND_HISTORY_DAYS &&
+           record.trendHead < TREND_HISTORY_DAYS &&
+           record.crc == checksum(record);
+}
+
+void DataStorage::addTrendSample(GoalRecord& record, uint16_t day, uint16_t progressCenti) {
+    if (record.trendCount > 0) {
+        uint8_t newest = (record.trendHead + TREND_HISTORY_DAYS - 1) % TREND_HISTORY_DAYS;
+        if (record.trend[newest].day == day) {
+            // Same day: keep the latest value
+            record.trend[newest].progressCenti = progressCenti;
+            return;
+        }
+    }
+
+    record.trend[record.trendHead] = {day, progressCenti};
+    record.trendHead = (record.trendHead + 1) % TREND_HISTORY_DAYS;
+    if (record.trendCount < TREND_HISTORY_DAYS) {
+        record.trendCount++;
+    }
+}
+
+uint32_t DataStorage::checksum(const GoalRecord& record) {
+    // Everything before the crc field
+    return crc32(0, (const uint8_t*)&record, offsetof(GoalRecord, crc));
 }
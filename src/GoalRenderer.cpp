@@ -0,0 +1,363 @@
+#include "GoalRenderer.h"
+#include "TimeKeeper.h"
+
+// Bitmaps generated at build time by tools/prerender.py
+#ifdef GOAL_PRERENDERED
+#include "Prerendered.h"
+#define PRERENDERED(bitmap) (&(bitmap))
+#else
+#define PRERENDERED(bitmap) nullptr
+#endif
+
+#define TREND_MIN_RANGE 10  // hundredths of a percent
+
+bool GoalRenderer::usePrerendered = true;
+
+// Collects printed text, so numbers are formatted exactly like gfx.print()
+class TextBuffer : public Print {
+public:
+    char text[16] = "";
+
+    size_t write(uint8_t c) override {
+        if (length + 1 >= sizeof(text)) {
+            return 0;
+        }
+        text[length++] = c;
+        text[length] = '\0';
+        return 1;
+    }
+    using Print::write;
+
+private:
+    size_t length = 0;
+};
+
+template <const DisplayLayout& L>
+void GoalRenderer::draw(Adafruit_GFX& gfx, const GoalData& data) {
+    gfx.fillScreen(GxEPD_WHITE);
+
+    // Title at top left: the goal's name when there are several
+    if (data.name[0] != '\0') {
+        gfx.setFont(&FreeMonoBold12pt7b);
+        gfx.setCursor(L.marginLeft, L.titleY);
+        gfx.print(data.name);
+    } else {
+        drawLabel(gfx, L.marginLeft, L.titleY, "DAYS TO GOAL", PRERENDERED(LABEL_DAYS_TO_GOAL));
+    }
+
+    // Error/offline indicator - top right
+    if (!data.lastUpdateSuccess) {
+        drawErrorIcon<L>(gfx);
+    }
+
+    // Left side - Days remaining
+    TextBuffer days;
+    days.print(data.daysToGoal);
+    drawLargeText(gfx, L.marginLeft, L.mainTextY, days.text);
+
+    drawLabel(gfx, L.marginLeft, L.subtitleY, "DAYS LEFT", PRERENDERED(LABEL_DAYS_LEFT));
+
+    // Calculate years from days
+    int years = data.daysToGoal / 365;
+    int months = (data.daysToGoal % 365) / 30;
+
+    gfx.setFont();
+    gfx.setCursor(L.marginLeft, L.detailY);
+    gfx.print("~");
+    gfx.print(years);
+    gfx.print("y ");
+    gfx.print(months);
+    gfx.print("m");
+
+    // Vertical divider line (stops before progress bar)
+    gfx.drawLine(L.dividerX, L.marginTop, L.dividerX, L.dividerEndY, GxEPD_BLACK);
+
+    // Right side - Progress percentage
+    TextBuffer progress;
+    progress.print(data.progressPercent, 1);
+    progress.print("%");
+    drawLargeText(gfx, L.rightX(), L.mainTextY, progress.text);
+
+    drawLabel(gfx, L.rightX(), L.subtitleY, "COMPLETE", PRERENDERED(LABEL_COMPLETE));
+
+    // Progress trend of the last days, below the percentage
+    drawTrend<L>(gfx, data);
+
+    // Progress bar - horizontal at bottom
+    int barX = L.marginLeft;
+    int barY = L.progressBarY;
+    int barWidth = L.width - L.marginLeft - L.marginRight;
+    int barHeight = L.progressBarHeight;
+
+    // Draw outline
+    gfx.drawRect(barX, barY, barWidth, barHeight, GxEPD_BLACK);
+
+    // Fill progress
+    int fillWidth = progressFillWidth<L>(data.progressPercent);
+    if (fillWidth > 0) {
+        gfx.fillRect(barX + 2, barY + 2, fillWidth, barHeight - 4, GxEPD_BLACK);
+    }
+
+    // Target date display - centered below progress bar
+    gfx.setFont(&FreeMonoBold12pt7b);
+    int16_t x1, y1;
+    uint16_t w, h;
+    char date[DATE_TEXT_SIZE];
+    TimeKeeper::formatLocal(data.targetTime, TARGET_DATE_FORMAT, date, sizeof(date));
+    gfx.getTextBounds(date, 0, 0, &x1, &y1, &w, &h);
+    int dateX = (L.width - w) / 2;
+    gfx.setCursor(dateX, L.dateY);
+    gfx.print(date);
+
+    // Bottom info: last update time
+    char footer[48];
+    formatFooter(data, footer, sizeof(footer));
+    gfx.setFont();
+    gfx.setCursor(L.marginLeft, L.footerY());
+    gfx.print(footer);
+}
+
+void GoalRenderer::setPrerendered(bool enabled) {
+    usePrerendered = enabled;
+}
+
+void GoalRenderer::drawLabel(Adafruit_GFX& gfx, int16_t x, int16_t y, const char* text,
+                             const PrerenderedBitmap* bitmap) {
+#ifdef GOAL_PRERENDERED
+    if (usePrerendered) {
+        blit(gfx, x, y, *bitmap);
+        return;
+    }
+#endif
+    gfx.setFont(&FreeMonoBold12pt7b);
+    gfx.setCursor(x, y);
+    gfx.print(text);
+}
+
+void GoalRenderer::drawLargeText(Adafruit_GFX& gfx, int16_t x, int16_t y, const char* text) {
+    for (const char* c = text; *c; c++) {
+#ifdef GOAL_PRERENDERED
+        // Characters in the atlas are copied as bitmaps, anything else falls
+        // back to the font
+        const char* slot = usePrerendered ? strchr(ATLAS_CHARS, *c) : nullptr;
+        if (slot) {
+            const PrerenderedBitmap& glyph = ATLAS_GLYPHS[slot - ATLAS_CHARS];
+            blit(gfx, x, y, glyph);
+            x += glyph.advance;
+            continue;
+        }
+#endif
+        gfx.setFont(&FreeMonoBold24pt7b);
+        gfx.setCursor(x, y);
+        gfx.write(*c);
+        x = gfx.getCursorX();
+    }
+}
+
+#ifdef GOAL_PRERENDERED
+void GoalRenderer::blit(Adafruit_GFX& gfx, int16_t x, int16_t y, const PrerenderedBitmap& bitmap) {
+    // Like drawBitmap, but stops at the last set bit of each byte instead of
+    // testing every pixel of the box (the glyphs are mostly white)
+    const uint8_t* bits = bitmap.bits;
+    uint16_t rowBytes = (bitmap.width + 7) / 8;
+    x += bitmap.dx;
+    y += bitmap.dy;
+    gfx.startWrite();
+    for (uint16_t row = 0; row < bitmap.height; row++) {
+        for (uint16_t column = 0; column < rowBytes; column++) {
+            uint8_t byte = pgm_read_byte(bits++);
+            for (int16_t px = x + column * 8; byte; byte <<= 1, px++) {
+                if (byte & 0x80) {
+                    gfx.writePixel(px, y + row, GxEPD_BLACK);
+                }
+            }
+        }
+    }
+    gfx.endWrite();
+}
+#endif
+
+template <const DisplayLayout& L>
+void GoalRenderer::drawErrorIcon(Adafruit_GFX& gfx) {
+    // Draw a small "X" icon in circle to indicate error (top right)
+    int iconX = L.width - L.errorIconMargin;
+    int iconY = L.marginTop;
+    gfx.drawLine(iconX, iconY, iconX + 10, iconY + 10, GxEPD_BLACK);
+    gfx.drawLine(iconX + 10, iconY, iconX, iconY + 10, GxEPD_BLACK);
+    gfx.drawCircle(iconX + 5, iconY + 5, L.errorIconSize, GxEPD_BLACK);
+}
+
+template <const DisplayLayout& L>
+void GoalRenderer::drawTrend(Adafruit_GFX& gfx, const GoalData& data) {
+    if (data.trendCount < 2) {
+        return;
+    }
+
+    // Scale to the range of the samples, with a minimum range so day-to-day
+    // noise doesn't fill the whole height
+    uint16_t low = UINT16_MAX, high = 0;
+    for (uint8_t i = 0; i < data.trendCount; i++) {
+        uint16_t progress = data.trend[i].progressCenti;
+        low = min(low, progress);
+        high = max(high, progress);
+    }
+    int range = high - low;
+    if (range < TREND_MIN_RANGE) {
+        low = low > (TREND_MIN_RANGE - range) / 2 ? low - (TREND_MIN_RANGE - range) / 2 : 0;
+        range = TREND_MIN_RANGE;
+    }
+
+    // Horizontal position by date, so missed days show as longer segments
+    int width = L.width - L.rightX() - L.marginRight;
+    int firstDay = data.trend[0].day;
+    int span = max(data.trend[data.trendCount - 1].day - firstDay, 1);
+
+    int16_t lastX = 0, lastY = 0;
+    for (uint8_t i = 0; i < data.trendCount; i++) {
+        int16_t x = L.rightX() + (int32_t)(data.trend[i].day - firstDay) * (width - 1) / span;
+        int16_t y = L.trendY + L.trendHeight - 1 -
+                    (int32_t)(data.trend[i].progressCenti - low) * (L.trendHeight - 1) / range;
+        if (i > 0) {
+            gfx.drawLine(lastX, lastY, x, y, GxEPD_BLACK);
+        }
+        lastX = x;
+        lastY = y;
+    }
+}
+
+template <const DisplayLayout& L>
+FrameSignature GoalRenderer::makeSignature(const GoalData& data) {
+    char footer[48];
+    formatFooter(data, footer, sizeof(footer));
+    char date[DATE_TEXT_SIZE];
+    size_t dateLength = TimeKeeper::formatLocal(data.targetTime, TARGET_DATE_FORMAT, date, sizeof(date));
+
+    FrameSignature frame = {};
+    frame.daysToGoal = data.daysToGoal;
+    // Progress is drawn with one decimal, so compare at that precision
+    frame.progressTenths = (int16_t)lroundf(data.progressPercent * 10.0f);
+    frame.barFill = (int16_t)progressFillWidth<L>(data.progressPercent);
+    frame.targetDateHash = hashBytes(date, dateLength);
+    frame.footerHash = hashBytes(footer, strlen(footer));
+    frame.trendHash = hashBytes(data.trend, data.trendCount * sizeof(TrendSample));
+    frame.titleHash = hashBytes(data.name, strlen(data.name));
+    frame.errorIcon = !data.lastUpdateSuccess;
+    return frame;
+}
+
+uint8_t GoalRenderer::dirtyRegions(const FrameSignature& previous, const FrameSignature& current) {
+    uint8_t dirty = 0;
+    if (previous.daysToGoal != current.daysToGoal) dirty |= REGION_DAYS;
+    if (previous.progressTenths != current.progressTenths) dirty |= REGION_PROGRESS;
+    if (previous.barFill != current.barFill) dirty |= REGION_BAR;
+    if (previous.targetDateHash != current.targetDateHash) dirty |= REGION_DATE;
+    if (previous.footerHash != current.footerHash) dirty |= REGION_FOOTER;
+    if (previous.errorIcon != current.errorIcon) dirty |= REGION_ERROR_ICON;
+    if (previous.trendHash != current.trendHash) dirty |= REGION_TREND;
+    if (previous.titleHash != current.titleHash) dirty |= REGION_TITLE;
+    return dirty;
+}
+
+template <const DisplayLayout& L>
+GoalRenderer::Rect GoalRenderer::regionRect(Region region) {
+    switch (region) {
+        case REGION_DAYS:
+            // Days number and years/months detail, left of the divider
+            return {0, (int16_t)(L.titleY + 8), L.dividerX, (int16_t)(L.detailY + 10 - (L.titleY + 8))};
+        case REGION_PROGRESS:
+            // Percentage, right of the divider
+            return {(int16_t)(L.dividerX + 1), (int16_t)(L.titleY + 8), (int16_t)(L.width - L.dividerX - 1),
+                    (int16_t)(L.mainTextY + 12 - (L.titleY + 8))};
+        case REGION_BAR:
+            return {L.marginLeft, L.progressBarY, (int16_t)(L.width - L.marginLeft - L.marginRight),
+                    L.progressBarHeight};
+        case REGION_DATE:
+            return {0, (int16_t)(L.progressBarY + L.progressBarHeight + 1), L.width,
+                    (int16_t)(L.dateY + 8 - (L.progressBarY + L.progressBarHeight + 1))};
+        case REGION_FOOTER:
+            return {0, (int16_t)(L.footerY() - 3), L.width, L.footerHeight};
+        case REGION_ERROR_ICON:
+            // Circle centered 5px into the icon, the X inside it
+            return {(int16_t)(L.width - L.errorIconMargin + 5 - L.errorIconSize),
+                    (int16_t)(L.marginTop + 5 - L.errorIconSize), (int16_t)(2 * L.errorIconSize + 1),
+                    (int16_t)(2 * L.errorIconSize + 1)};
+        case REGION_TREND:
+            return {(int16_t)(L.dividerX + 1), (int16_t)(L.trendY - 1), (int16_t)(L.width - L.dividerX - 1),
+                    (int16_t)(L.trendHeight + 2)};
+        case REGION_TITLE:
+            return {0, 0, L.dividerX, (int16_t)(L.titleY + LABEL_FONT_DESCENT + 1)};
+    }
+    return {0, 0, L.width, L.height};
+}
+
+template <const DisplayLayout& L>
+GoalRenderer::Rect GoalRenderer::dirtyBounds(uint8_t dirty) {
+    // Merge the dirty regions into one window: a single partial refresh
+    // keeps the panel busy for less time than one refresh per region
+    int16_t left = L.width, top = L.height, right = 0, bottom = 0;
+    for (uint16_t bit = 1; bit <= REGION_TITLE; bit <<= 1) {
+        if (dirty & bit) {
+            Rect r = regionRect<L>((Region)bit);
+            left = min(left, r.x);
+            top = min(top, r.y);
+            right = max(right, (int16_t)(r.x + r.w));
+            bottom = max(bottom, (int16_t)(r.y + r.h));
+        }
+    }
+    if (right <= left || bottom <= top) {
+        return {0, 0, 0, 0};
+    }
+    return {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+template <const DisplayLayout& L>
+int GoalRenderer::progressFillWidth(float progressPercent) {
+    int barWidth = L.width - L.marginLeft - L.marginRight;
+    int fillWidth = (int)((progressPercent / 100.0) * (barWidth - 4));
+    // Ensure fillWidth doesn't exceed bar bounds
+    if (fillWidth > barWidth - 4) {
+        fillWidth = barWidth - 4;
+    }
+    if (fillWidth < 0) {
+        fillWidth = 0;
+    }
+    return fillWidth;
+}
+
+void GoalRenderer::formatFooter(const GoalData& data, char* buffer, size_t size) {
+    char updated[DATE_TEXT_SIZE];
+    TimeKeeper::formatLocal(data.dataTime, UPDATE_TIME_FORMAT, updated, sizeof(updated));
+    int length;
+    if (data.lastUpdateSuccess) {
+        length = snprintf(buffer, size, "Updated: %s", updated);
+    } else {
+        length = snprintf(buffer, size, "Last: %s (offline)", updated);
+    }
+
+    // Page indicator when the goals rotate
+    if (data.pageCount > 1 && length >= 0 && (size_t)length < size) {
+        snprintf(buffer + length, size - length, " %u/%u", data.page + 1, data.pageCount);
+    }
+}
+
+uint32_t GoalRenderer::hashBytes(const void* bytes, size_t size) {
+    // FNV-1a
+    const uint8_t* data = (const uint8_t*)bytes;
+    uint32_t hash = 2166136261u;
+    while (size--) {
+        hash ^= *data++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Specializations for every layout in DisplayLayout.h; the linker drops the
+// ones a build doesn't use
+#define INSTANTIATE_LAYOUT(layout) \
+    template void GoalRenderer::draw<layout>(Adafruit_GFX& gfx, const GoalData& data); \
+    template FrameSignature GoalRenderer::makeSignature<layout>(const GoalData& data); \
+    template GoalRenderer::Rect GoalRenderer::regionRect<layout>(Region region); \
+    template GoalRenderer::Rect GoalRenderer::dirtyBounds<layout>(uint8_t dirty);
+
+INSTANTIATE_LAYOUT(LAYOUT_416X240)
+INSTANTIATE_LAYOUT(LAYOUT_400X300)
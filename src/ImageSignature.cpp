@@ -0,0 +1,65 @@
+#include "ImageSignature.h"
+#include "Log.h"
+#include <mbedtls/version.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/sha256.h>
+
+// Hash of the image being written
+static mbedtls_sha256_context hashContext;
+
+void ImageSignature::begin() {
+    mbedtls_sha256_init(&hashContext);
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_sha256_starts(&hashContext, 0);
+#else
+    mbedtls_sha256_starts_ret(&hashContext, 0);
+#endif
+}
+
+void ImageSignature::update(const uint8_t* bytes, size_t size) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_sha256_update(&hashContext, bytes, size);
+#else
+    mbedtls_sha256_update_ret(&hashContext, bytes, size);
+#endif
+}
+
+bool ImageSignature::verify(const char* signature, const char* publicKey) {
+    uint8_t digest[32];
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_sha256_finish(&hashContext, digest);
+#else
+    mbedtls_sha256_finish_ret(&hashContext, digest);
+#endif
+    mbedtls_sha256_free(&hashContext);
+
+    // Hex digits to the DER signature openssl writes
+    uint8_t der[IMAGE_SIGNATURE_SIZE / 2];
+    size_t length = strlen(signature);
+    if (length == 0 || length % 2 != 0 || length / 2 > sizeof(der)) {
+        LOG_ERROR("OTA: malformed image signature");
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = signature[i];
+        if (!isxdigit((unsigned char)c)) {
+            LOG_ERROR("OTA: malformed image signature");
+            return false;
+        }
+        uint8_t value = isdigit((unsigned char)c) ? c - '0' : (tolower((unsigned char)c) - 'a' + 10);
+        der[i / 2] = (i % 2) ? (der[i / 2] | value) : (value << 4);
+    }
+
+    mbedtls_pk_context key;
+    mbedtls_pk_init(&key);
+    bool valid = false;
+    // The PEM parser wants the terminator counted
+    int ret = mbedtls_pk_parse_public_key(&key, (const unsigned char*)publicKey, strlen(publicKey) + 1);
+    if (ret != 0 || !mbedtls_pk_can_do(&key, MBEDTLS_PK_ECDSA)) {
+        LOG_ERROR("OTA_PUBLIC_KEY is not a PEM EC public key: -0x%04X", (unsigned)-ret);
+    } else {
+        valid = mbedtls_pk_verify(&key, MBEDTLS_MD_SHA256, digest, sizeof(digest), der, length / 2) == 0;
+    }
+    mbedtls_pk_free(&key);
+    return valid;
+}
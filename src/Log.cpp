@@ -0,0 +1,148 @@
+#include "Log.h"
+
+#define LOG_RING_SIZE (LOG_RTC_ENTRIES > 0 ? LOG_RTC_ENTRIES : 1)
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR LogRecord Log::rtc_records[LOG_RING_SIZE] = {};
+RTC_DATA_ATTR uint8_t Log::rtc_head = 0;
+RTC_DATA_ATTR uint8_t Log::rtc_count = 0;
+RTC_DATA_ATTR uint8_t Log::rtc_pending = 0;
+
+static const char LEVEL_LETTERS[] = "-EWID";
+
+void Log::begin() {
+#if LOG_LEVEL > LOG_LEVEL_NONE
+    Serial.begin(115200);
+#if DEBUG_MODE
+    // Time to open the USB console after a reset, only worth it when debugging
+    delay(1000);
+    if (rtc_count > 0) {
+        Serial.println("Log records kept in RTC memory:");
+        dump(Serial);
+    }
+#endif
+#endif
+}
+
+void Log::flush() {
+#if LOG_LEVEL > LOG_LEVEL_NONE
+    Serial.flush();
+#endif
+}
+
+void Log::record(uint8_t level, const char* format, const uint32_t* values) {
+    // Oldest record is overwritten once the ring is full
+    LogRecord& record = rtc_records[rtc_head];
+    record.time = (uint32_t)time(nullptr);
+    record.format = format;
+    memcpy(record.values, values, sizeof(record.values));
+    record.level = level;
+
+    rtc_head = (rtc_head + 1) % LOG_RING_SIZE;
+    if (rtc_count < LOG_RING_SIZE) {
+        rtc_count++;
+    }
+    if (rtc_pending < LOG_RING_SIZE) {
+        rtc_pending++;
+    }
+}
+
+size_t Log::formatRecord(const LogRecord& record, char* buffer, size_t size) {
+    // Applies the format again, one conversion at a time, to the stored values
+    size_t len = snprintf(buffer, size, "%c%lu ", LEVEL_LETTERS[record.level % 5],
+                          (unsigned long)record.time);
+    uint8_t next = 0;
+    const char* p = record.format;
+    while (*p && len + 1 < size) {
+        if (*p != '%') {
+            buffer[len++] = *p++;
+            continue;
+        }
+        const char* start = p++;
+        if (*p == '%') {
+            buffer[len++] = *p++;
+            continue;
+        }
+
+        // Flags, width and precision are kept, length modifiers dropped
+        // (values are 32 bits)
+        while (*p && strchr("-+ #0123456789.", *p)) {
+            p++;
+        }
+        size_t specLen = min((size_t)(p - start), (size_t)12);
+        while (*p && strchr("hlLqjzt", *p)) {
+            p++;
+        }
+        char type = *p ? *p++ : 's';
+        char spec[16];
+        memcpy(spec, start, specLen);
+        spec[specLen++] = type;
+        spec[specLen] = '\0';
+
+        bool stored = next < LOG_RECORD_VALUES;
+        uint32_t value = stored ? record.values[next] : 0;
+        next++;
+        int n;
+        if (!stored || type == 's' || type == 'p') {
+            n = snprintf(buffer + len, size - len, "?");
+        } else if (strchr("fFeEgGaA", type)) {
+            float f;
+            memcpy(&f, &value, sizeof(f));
+            n = snprintf(buffer + len, size - len, spec, (double)f);
+        } else if (type == 'd' || type == 'i' || type == 'c') {
+            n = snprintf(buffer + len, size - len, spec, (int)value);
+        } else {
+            n = snprintf(buffer + len, size - len, spec, (unsigned)value);
+        }
+        if (n > 0) {
+            len = min(len + n, size - 1);
+        }
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+bool Log::hasPending() {
+    return rtc_pending > 0;
+}
+
+size_t Log::formatPending(char* buffer, size_t size) {
+    // Records separated by "|", oldest first: <level><time> <message>. The
+    // oldest are left out if they don't all fit.
+    for (uint8_t skip = 0; skip < rtc_pending; skip++) {
+        size_t len = 0;
+        uint8_t first = (rtc_head + LOG_RING_SIZE - rtc_pending + skip) % LOG_RING_SIZE;
+        for (uint8_t i = 0; i < rtc_pending - skip && len < size; i++) {
+            if (i > 0) {
+                buffer[len++] = '|';
+            }
+            char line[LOG_LINE_SIZE];
+            size_t n = formatRecord(rtc_records[(first + i) % LOG_RING_SIZE], line, sizeof(line));
+            for (size_t c = 0; c < n; c++) {
+                // Keep the header value clean
+                if (line[c] == '|' || line[c] < ' ') {
+                    line[c] = ' ';
+                }
+            }
+            len += snprintf(buffer + len, size - len, "%s", line);
+        }
+        if (len < size) {
+            return len;
+        }
+    }
+    buffer[0] = '\0';
+    return 0;
+}
+
+void Log::clearPending() {
+    rtc_pending = 0;
+}
+
+void Log::dump(Print& out) {
+    uint8_t first = (rtc_head + LOG_RING_SIZE - rtc_count) % LOG_RING_SIZE;
+    for (uint8_t i = 0; i < rtc_count; i++) {
+        char line[LOG_LINE_SIZE];
+        formatRecord(rtc_records[(first + i) % LOG_RING_SIZE], line, sizeof(line));
+        out.println(line);
+    }
+}
@@ -1,7 +1,23 @@
 #include "NetworkManager.h"
+#include "Log.h"
+
+// "Bearer <API_TOKEN>" with its terminator, built on the stack
+constexpr size_t AUTHORIZATION_SIZE = sizeof("Bearer ") + __builtin_strlen(API_TOKEN);
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR uint8_t NetworkManager::rtc_bssid[6] = {0};
+RTC_DATA_ATTR int32_t NetworkManager::rtc_channel = 0;
+RTC_DATA_ATTR uint32_t NetworkManager::rtc_localIP = 0;
+RTC_DATA_ATTR uint32_t NetworkManager::rtc_gateway = 0;
+RTC_DATA_ATTR uint32_t NetworkManager::rtc_subnet = 0;
+RTC_DATA_ATTR uint32_t NetworkManager::rtc_dns = 0;
+RTC_DATA_ATTR time_t NetworkManager::rtc_leaseEpoch = 0;
+RTC_DATA_ATTR bool NetworkManager::rtc_hasConnection = false;
+RTC_DATA_ATTR char NetworkManager::rtc_etag[64] = "";
+RTC_DATA_ATTR char NetworkManager::rtc_lastModified[32] = "";
 
 bool NetworkManager::connectWiFi() {
-    Serial.println("\n===== WiFi Connection =====");
+    LOG_DEBUG("===== WiFi Connection =====");
 
     // Set station mode
     WiFi.mode(WIFI_STA);
@@ -16,156 +32,366 @@ bool NetworkManager::connectWiFi() {
     // Set hostname
     WiFi.setHostname("ESP32-GoalTracker");
 
-    delay(100);
+    // Try paths from cheapest to most expensive:
+    // cached AP + lease -> scan of the cached channel -> full scan
+    unsigned long startMs = millis();
+    bool connected = false;
 
-    // Scan for target network
-    Serial.println("Scanning for WiFi networks...");
-    int n = WiFi.scanNetworks();
-    Serial.print("Found ");
-    Serial.print(n);
-    Serial.println(" networks");
+    if (rtc_hasConnection) {
+        connected = connectCached();
+        if (connected) {
+            logConnectTime("cached AP", startMs);
+        }
+    }
+
+    if (!connected && rtc_hasConnection && CircuitBreaker::remainingMs() > 0) {
+        startMs = millis();
+        connected = connectByScan(rtc_channel);
+        if (connected) {
+            logConnectTime("channel scan", startMs);
+        }
+    }
+
+    if (!connected && CircuitBreaker::remainingMs() > 0) {
+        startMs = millis();
+        connected = connectByScan(0);
+        if (connected) {
+            logConnectTime("full scan", startMs);
+        }
+    }
+
+    if (connected) {
+        LOG_INFO("WiFi connected, IP %s, RSSI %d dBm",
+                 WiFi.localIP().toString().c_str(), (int)WiFi.RSSI());
+
+        saveConnection();
+        WakeProfiler::setRssi((int8_t)WiFi.RSSI());
+        return true;
+    } else {
+        // Cached AP is no longer reachable, forget it
+        rtc_hasConnection = false;
+        LOG_ERROR("WiFi connection failed");
+        return false;
+    }
+}
+
+void NetworkManager::disconnect() {
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+}
+
+bool NetworkManager::connectCached() {
+    bool useStaticIP = rtc_localIP != 0 && leaseFresh();
+
+    LOG_DEBUG("Connecting to cached AP on channel %ld (%s)", (long)rtc_channel,
+              useStaticIP ? "static IP" : "DHCP");
+
+    if (useStaticIP) {
+        // Reuse the last DHCP lease so we skip the DHCP round trip
+        WiFi.config(IPAddress(rtc_localIP), IPAddress(rtc_gateway),
+                    IPAddress(rtc_subnet), IPAddress(rtc_dns));
+    }
+
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD, rtc_channel, rtc_bssid, true);
+
+    if (waitForConnection(TIMEOUT_ASSOCIATE)) {
+        if (!useStaticIP) {
+            startLease();
+        }
+        return true;
+    }
+
+    LOG_WARN("Cached AP failed, falling back to scan");
+    WiFi.disconnect();
+    if (useStaticIP) {
+        // Back to DHCP for the scan paths
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    }
+    return false;
+}
+
+bool NetworkManager::connectByScan(int32_t channel) {
+    // Scan for target network (channel 0 = all channels)
+    if (channel > 0) {
+        LOG_DEBUG("Scanning channel %ld...", (long)channel);
+    } else {
+        LOG_DEBUG("Scanning for WiFi networks...");
+    }
+    WakeProfiler::start(PHASE_SCAN);
+    int n = WiFi.scanNetworks(false, false, false, 300, channel);
+    WakeProfiler::stop(PHASE_SCAN);
+    LOG_DEBUG("Found %d networks", n);
 
     // Find target network and get BSSID + channel
     int targetIndex = -1;
     for (int i = 0; i < n; i++) {
-        if (WiFi.SSID(i) == String(WIFI_SSID)) {
+        if (WiFi.SSID(i) == WIFI_SSID) {
             targetIndex = i;
-            Serial.print("Target network found: ");
-            Serial.print(WiFi.SSID(i));
-            Serial.print(" (");
-            Serial.print(WiFi.RSSI(i));
-            Serial.println(" dBm)");
+            LOG_DEBUG("Target network found: %s (%d dBm)", WiFi.SSID(i).c_str(), (int)WiFi.RSSI(i));
             break;
         }
     }
 
     if (targetIndex < 0) {
-        Serial.println("ERROR: Network not found!");
+        LOG_ERROR("Network not found (channel %ld)", (long)channel);
+        WiFi.scanDelete();
         return false;
     }
 
     // Get network details
-    uint8_t* bssid = WiFi.BSSID(targetIndex);
-    int32_t channel = WiFi.channel(targetIndex);
+    uint8_t bssid[6];
+    memcpy(bssid, WiFi.BSSID(targetIndex), sizeof(bssid));
+    int32_t targetChannel = WiFi.channel(targetIndex);
+    WiFi.scanDelete();
 
-    Serial.print("BSSID: ");
-    for (int i = 0; i < 6; i++) {
-        Serial.printf("%02X", bssid[i]);
-        if (i < 5) Serial.print(":");
-    }
-    Serial.println();
-    Serial.print("Channel: ");
-    Serial.println(channel);
+    LOG_DEBUG("BSSID: %02X:%02X:%02X:%02X:%02X:%02X, channel %ld", bssid[0], bssid[1],
+              bssid[2], bssid[3], bssid[4], bssid[5], (long)targetChannel);
 
     // Connect with BSSID + Channel for reliable connection
-    Serial.println("\nConnecting...");
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD, channel, bssid, true);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD, targetChannel, bssid, true);
 
-    // Wait for connection (20 seconds timeout)
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
+    if (waitForConnection(TIMEOUT_ASSOCIATE_SCAN)) {
+        startLease();
+        return true;
     }
 
+    WiFi.disconnect();
+    return false;
+}
+
+bool NetworkManager::waitForConnection(TimeoutPhase phase) {
+    // Learned from previous wakes, never past the wake's time budget
+    unsigned long timeoutMs = CircuitBreaker::limitTimeout(AdaptiveTimeout::get(phase));
+
+    // Poll in short steps so a fast association isn't rounded up to 500 ms
+    WakeProfiler::start(PHASE_ASSOCIATE);
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED && millis() - start < timeoutMs) {
+        delay(20);
+    }
+    WakeProfiler::stop(PHASE_ASSOCIATE);
+
     if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\n✓ WiFi connected!");
-        Serial.print("IP: ");
-        Serial.println(WiFi.localIP());
-        Serial.print("RSSI: ");
-        Serial.print(WiFi.RSSI());
-        Serial.println(" dBm");
-        Serial.println("===========================\n");
-
-        // Sync time with NTP server
-        syncTime();
+        AdaptiveTimeout::record(phase, millis() - start);
         return true;
-    } else {
-        Serial.println("\n✗ Connection failed!");
-        return false;
     }
+    LOG_DEBUG("%s timed out after %lu ms", AdaptiveTimeout::phaseName(phase), timeoutMs);
+    AdaptiveTimeout::recordTimeout(phase);
+    return false;
 }
 
-void NetworkManager::syncTime() {
-    Serial.println("Syncing time with NTP server...");
-    // Configure time with NTP (using timezone from config)
-    configTime(TIMEZONE_OFFSET, 0, "pool.ntp.org", "time.nist.gov");
+void NetworkManager::startLease() {
+    // Before the first NTP sync the lease's start is unknown (0), so the
+    // next wake asks DHCP again
+    rtc_leaseEpoch = TimeKeeper::isTimeValid() ? time(nullptr) : 0;
+}
 
-    // Wait for time to be set
-    int retry = 0;
-    const int retry_count = 10;
-    while (time(nullptr) < 100000 && ++retry < retry_count) {
-        Serial.print(".");
-        delay(500);
+bool NetworkManager::leaseFresh() {
+    if (rtc_leaseEpoch == 0 || !TimeKeeper::isTimeValid()) {
+        return false;
     }
+    time_t age = time(nullptr) - rtc_leaseEpoch;
+    return age >= 0 && age < (time_t)WIFI_STATIC_IP_MAX_AGE;
+}
 
-    if (retry < retry_count) {
-        Serial.println("\nTime synchronized!");
-    } else {
-        Serial.println("\nTime sync failed, using local time");
+void NetworkManager::saveConnection() {
+    // Latencies learned on another network don't apply here
+    if (rtc_channel != 0 && memcmp(rtc_bssid, WiFi.BSSID(), sizeof(rtc_bssid)) != 0) {
+        LOG_INFO("New access point, relearning network timeouts");
+        AdaptiveTimeout::relearn();
     }
+    memcpy(rtc_bssid, WiFi.BSSID(), sizeof(rtc_bssid));
+    rtc_channel = WiFi.channel();
+    rtc_localIP = (uint32_t)WiFi.localIP();
+    rtc_gateway = (uint32_t)WiFi.gatewayIP();
+    rtc_subnet = (uint32_t)WiFi.subnetMask();
+    rtc_dns = (uint32_t)WiFi.dnsIP();
+    rtc_hasConnection = true;
+}
+
+void NetworkManager::logConnectTime(const char* path, unsigned long startMs) {
+    LOG_INFO("Connected via %s in %lu ms", path, millis() - startMs);
 }
 
-String NetworkManager::formatTimestamp(const char* isoTimestamp) {
-    // Parse ISO 8601 timestamp: "2025-10-28T11:51:53.666Z"
-    if (!isoTimestamp || strlen(isoTimestamp) < 19) {
-        return "N/A";
+time_t NetworkManager::projectTarget(int daysToGoal) {
+    // Calculate target date by adding days to current date
+    return TimeKeeper::isTimeValid() ? time(nullptr) + (time_t)daysToGoal * 86400 : 0;
+}
+
+// Reader that stops after a fixed number of bytes so an oversized or
+// never-ending body can't exhaust the heap while streaming into ArduinoJson.
+// Every read waits up to the stream timeout: a socket's read() returns -1
+// between TCP segments, which the parser would take as the end of the body.
+class BoundedStreamReader {
+public:
+    BoundedStreamReader(Stream& stream, size_t limit) : stream(stream), remaining(limit), total(0) {}
+
+    int read() {
+        if (remaining == 0) {
+            return -1;
+        }
+        uint8_t c;
+        if (stream.readBytes((char*)&c, 1) != 1) {
+            return -1;
+        }
+        remaining--;
+        total++;
+        return c;
     }
 
-    struct tm timeinfo = {0};
-    int year, month, day, hour, minute, second;
+    size_t readBytes(char* buffer, size_t length) {
+        if (length > remaining) {
+            length = remaining;
+        }
+        size_t n = stream.readBytes(buffer, length);
+        remaining -= n;
+        total += n;
+        return n;
+    }
 
-    // Parse the ISO timestamp
-    if (sscanf(isoTimestamp, "%d-%d-%dT%d:%d:%d",
-               &year, &month, &day, &hour, &minute, &second) == 6) {
+    size_t bytesRead() const { return total; }
+    bool limitReached() const { return remaining == 0; }
 
-        timeinfo.tm_year = year - 1900;
-        timeinfo.tm_mon = month - 1;
-        timeinfo.tm_mday = day;
-        timeinfo.tm_hour = hour;
-        timeinfo.tm_min = minute;
-        timeinfo.tm_sec = second;
+private:
+    Stream& stream;
+    size_t remaining;
+    size_t total;
+};
 
-        // Convert to local time
-        time_t timestamp = mktime(&timeinfo);
-        // Add timezone offset to convert from UTC
-        timestamp += TIMEZONE_OFFSET;
-        localtime_r(&timestamp, &timeinfo);
+// Response body format, from its Content-Type
+static bool isMsgPack(const char* contentType) {
+    return strncmp(contentType, "application/msgpack", 19) == 0 ||
+           strncmp(contentType, "application/x-msgpack", 21) == 0 ||
+           strncmp(contentType, "application/vnd.msgpack", 23) == 0;
+}
 
-        // Format: "MM/DD HH:MM"
-        char timeStr[20];
-        strftime(timeStr, sizeof(timeStr), "%m/%d %H:%M", &timeinfo);
-        return String(timeStr);
+void NetworkManager::storeValidators(HTTPClient& http) {
+    // Values that don't fit are dropped rather than truncated, a truncated
+    // ETag would never match
+    String etag = http.header("ETag");
+    if (etag.length() < sizeof(rtc_etag)) {
+        strcpy(rtc_etag, etag.c_str());
+    } else {
+        rtc_etag[0] = '\0';
     }
 
-    return "N/A";
+    String lastModified = http.header("Last-Modified");
+    if (lastModified.length() < sizeof(rtc_lastModified)) {
+        strcpy(rtc_lastModified, lastModified.c_str());
+    } else {
+        rtc_lastModified[0] = '\0';
+    }
 }
 
-String NetworkManager::getTargetDate(int daysToGoal) {
-    time_t now = time(nullptr);
-    struct tm timeinfo;
+void NetworkManager::readMaxAge(HTTPClient& http) {
+    // Cache-Control: max-age=N tells us how long the data stays current
+    String cacheControl = http.header("Cache-Control");
+    const char* maxAge = strstr(cacheControl.c_str(), "max-age=");
+    if (maxAge) {
+        long seconds = atol(maxAge + strlen("max-age="));
+        if (seconds > 0) {
+            WakeScheduler::setServerHint((uint32_t)seconds);
+        }
+    }
+}
+
+void NetworkManager::buildFilter(JsonDocument& filter) {
+    // Only these fields are kept in the document, everything else is skipped.
+    // A single goal sits at the top level, a batch in the "goals" array.
+    filter["projection"]["days_to_target"] = true;
+    filter["goal_tracking"]["current_progress_percent"] = true;
+    filter["metadata"]["data_timestamp"] = true;
+    filter["next_update_at"] = true;
+    filter["firmware"]["version"] = true;
+    filter["firmware"]["url"] = true;
+    filter["firmware"]["signature"] = true;
+
+    JsonObject goal = filter["goals"].add<JsonObject>();
+    goal["name"] = true;
+    goal["projection"]["days_to_target"] = true;
+    goal["goal_tracking"]["current_progress_percent"] = true;
+    goal["metadata"]["data_timestamp"] = true;
+}
 
-    if (!getLocalTime(&timeinfo) || now < 100000) {
-        // If time sync failed, return N/A instead of incorrect date
-        return "N/A";
+uint8_t NetworkManager::extractGoals(JsonDocument& doc, GoalData* goals, uint8_t maxGoals) {
+    uint8_t count = 0;
+    JsonArrayConst batch = doc["goals"];
+    if (batch.isNull()) {
+        extractGoalData(doc.as<JsonVariantConst>(), goals[0]);
+        count = 1;
+    } else {
+        for (JsonVariantConst goal : batch) {
+            if (count == maxGoals) {
+                LOG_WARN("More goals than GOAL_COUNT, ignoring the rest");
+                break;
+            }
+            extractGoalData(goal, goals[count++]);
+        }
     }
 
-    // Calculate target date by adding days to current date
-    time_t targetTime = now + (daysToGoal * 86400); // 86400 seconds per day
-    struct tm targetDate;
-    localtime_r(&targetTime, &targetDate);
-
-    // Format: "Day, Mon DD, YYYY" (e.g., "Mon, Oct 27, 2025")
-    char dateStr[30];
-    strftime(dateStr, sizeof(dateStr), "%a, %b %d, %Y", &targetDate);
-    return String(dateStr);
+    // Optional hint when the server expects new data
+    const char* nextUpdateAt = doc["next_update_at"];
+    time_t nextUpdate = TimeKeeper::parseIsoTime(nextUpdateAt);
+    if (nextUpdate > 0 && TimeKeeper::isTimeValid() && nextUpdate > time(nullptr)) {
+        WakeScheduler::setServerHint((uint32_t)(nextUpdate - time(nullptr)));
+    }
+
+    // Firmware update offered for the version we sent
+    if (OtaUpdater::enabled()) {
+        JsonVariantConst firmware = doc["firmware"];
+        if (!firmware.isNull()) {
+            OtaUpdater::offer(firmware["version"], firmware["url"], firmware["signature"]);
+        }
+    }
+
+    return count;
 }
 
-bool NetworkManager::fetchMockData(GoalData& data) {
-    Serial.println("Using MOCK data for testing...");
+void NetworkManager::extractGoalData(JsonVariantConst goal, GoalData& data) {
+    // Strings are copied out of the document, which is freed after parsing
+    const char* name = goal["name"] | "";
+    strncpy(data.name, name, GOAL_NAME_SIZE - 1);
+    data.name[GOAL_NAME_SIZE - 1] = '\0';
+    data.daysToGoal = goal["projection"]["days_to_target"];
+    data.progressPercent = goal["goal_tracking"]["current_progress_percent"];
+    data.targetTime = projectTarget(data.daysToGoal);
+
+    // Timestamp from metadata, formatted when drawn
+    const char* timestamp = goal["metadata"]["data_timestamp"];
+    data.dataTime = TimeKeeper::parseIsoTime(timestamp);
 
-    // Mock JSON response matching actual API format
+    data.isValid = true;
+
+    LOG_DEBUG("Goal '%s': %d days to goal, progress %.2f%%, data timestamp %lu",
+              data.name, data.daysToGoal, data.progressPercent, (unsigned long)data.dataTime);
+}
+
+bool NetworkManager::fetchMockData(GoalData* goals, uint8_t maxGoals, uint8_t& count) {
+    LOG_INFO("Using MOCK data for testing...");
+
+    // Mock JSON responses matching actual API format
+    const char* mockBatchJson = R"({
+        "goals": [
+            {
+                "name": "RETIREMENT",
+                "goal_tracking": {"current_progress_percent": 22.2},
+                "projection": {"days_to_target": 3750},
+                "metadata": {"data_timestamp": "2025-10-28T11:51:53.666Z"}
+            },
+            {
+                "name": "HOUSE",
+                "goal_tracking": {"current_progress_percent": 61.5},
+                "projection": {"days_to_target": 910},
+                "metadata": {"data_timestamp": "2025-10-28T11:51:53.666Z"}
+            },
+            {
+                "name": "EMERGENCY",
+                "goal_tracking": {"current_progress_percent": 88.0},
+                "projection": {"days_to_target": 120},
+                "metadata": {"data_timestamp": "2025-10-28T11:51:53.666Z"}
+            }
+        ]
+    })";
     const char* mockJson = R"({
         "goal_tracking": {
             "current_progress_percent": 22.2
@@ -178,95 +404,176 @@ bool NetworkManager::fetchMockData(GoalData& data) {
         }
     })";
 
-    // Parse mock JSON (ArduinoJson v7 uses dynamic allocation automatically)
+    JsonDocument filter;
+    buildFilter(filter);
+
     JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, mockJson);
+    DeserializationError error = deserializeJson(doc, GOAL_COUNT > 1 ? mockBatchJson : mockJson,
+                                                 DeserializationOption::Filter(filter));
 
     if (error) {
-        Serial.print("Mock JSON parsing failed: ");
-        Serial.println(error.c_str());
+        LOG_ERROR("Mock JSON parsing failed: %s", error.c_str());
         return false;
     }
 
-    // Extract data
-    data.daysToGoal = doc["projection"]["days_to_target"];
-    data.progressPercent = doc["goal_tracking"]["current_progress_percent"];
-
-    // Extract and format timestamp from metadata
-    const char* timestamp = doc["metadata"]["data_timestamp"];
-    data.lastUpdateTime = formatTimestamp(timestamp);
-
-    data.isValid = true;
-
-    Serial.print("Days to goal: ");
-    Serial.println(data.daysToGoal);
-    Serial.print("Progress: ");
-    Serial.print(data.progressPercent);
-    Serial.println("%");
-    Serial.print("Data timestamp: ");
-    Serial.println(data.lastUpdateTime);
-
-    return true;
+    count = extractGoals(doc, goals, maxGoals);
+    return count > 0;
 }
 
 bool NetworkManager::fetchGoalData(GoalData& data) {
+    uint8_t count = 0;
+    return fetchGoals(&data, 1, count);
+}
+
+bool NetworkManager::fetchGoals(GoalData* goals, uint8_t maxGoals, uint8_t& count) {
+    count = 0;
+
     // Use mock data if enabled
     if (MOCK_MODE) {
-        return fetchMockData(data);
+        return fetchMockData(goals, maxGoals, count);
     }
 
     // Real API call
     if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("WiFi not connected");
+        LOG_ERROR("WiFi not connected");
         return false;
     }
 
+    // Declared first so it outlives the HTTPClient using it
+    TlsClient tls;
     HTTPClient http;
-    http.begin(API_URL);
-    http.addHeader("Authorization", String("Bearer ") + API_TOKEN);
-    http.setTimeout(10000);  // 10 second timeout
+    // HTTP/1.0 avoids chunked transfer encoding so the body can be
+    // parsed straight from the socket
+    http.useHTTP10(true);
+    if (strncmp(API_URL, "https://", 8) == 0) {
+        http.begin(tls, API_URL);
+    } else {
+        http.begin(API_URL);
+    }
+    char authorization[AUTHORIZATION_SIZE];
+    snprintf(authorization, sizeof(authorization), "Bearer %s", API_TOKEN);
+    http.addHeader("Authorization", authorization);
+    // Learned response time, within the wake budget
+    unsigned long timeoutMs = CircuitBreaker::limitTimeout(AdaptiveTimeout::get(TIMEOUT_HTTP));
+    http.setTimeout(timeoutMs);
+
+    // Conditional GET: let the server answer 304 if our cached data is current
+    const char* headerKeys[] = {"ETag", "Last-Modified", "Cache-Control", "Content-Type"};
+    http.collectHeaders(headerKeys, 4);
+    bool haveCache = DataStorage::hasData();
+    if (haveCache && rtc_etag[0] != '\0') {
+        http.addHeader("If-None-Match", rtc_etag);
+    }
+    if (haveCache && rtc_lastModified[0] != '\0') {
+        http.addHeader("If-Modified-Since", rtc_lastModified);
+    }
+
+    // Servers without MessagePack support answer with JSON
+    http.addHeader("Accept", PREFER_MSGPACK ? "application/msgpack, application/json;q=0.5"
+                                            : "application/json");
+
+    // Lets the server offer an update from this version
+    if (OtaUpdater::enabled()) {
+        http.addHeader("X-Firmware-Version", FIRMWARE_VERSION);
+    }
+
+    // Attach timings of previous wakes for fleet-wide latency tracking
+    if (WakeProfiler::hasPending()) {
+        char profile[WAKE_PROFILE_TEXT_SIZE];
+        if (WakeProfiler::formatPending(profile, sizeof(profile)) > 0) {
+            http.addHeader("X-Wake-Profile", profile);
+        }
+    }
+    // And the warnings and errors they logged
+    if (Log::hasPending()) {
+        char log[LOG_UPLOAD_SIZE];
+        if (Log::formatPending(log, sizeof(log)) > 0) {
+            http.addHeader("X-Device-Log", log);
+        }
+    }
 
-    Serial.println("Fetching data from API...");
+    LOG_DEBUG("Fetching data from API...");
+    WakeProfiler::start(PHASE_HTTP);
+    unsigned long requestStart = millis();
     int httpCode = http.GET();
+    WakeProfiler::stop(PHASE_HTTP);
+
+    // The handshake has timeouts of its own
+    if (httpCode > 0) {
+        AdaptiveTimeout::record(TIMEOUT_HTTP, millis() - requestStart - tls.connectTime());
+    } else if (httpCode == HTTPC_ERROR_READ_TIMEOUT) {
+        LOG_DEBUG("No response within %lu ms", timeoutMs);
+        AdaptiveTimeout::recordTimeout(TIMEOUT_HTTP);
+    }
 
-    if (httpCode == 200) {
-        String payload = http.getString();
-        Serial.println("Response received");
+    if (httpCode == 200 || httpCode == 304) {
+        // Server has the buffered profiles and log records now
+        WakeProfiler::clearPending();
+        Log::clearPending();
+        readMaxAge(http);
+    }
 
-        // Parse JSON (ArduinoJson v7 uses dynamic allocation automatically)
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, payload);
+    if (httpCode == 304 && haveCache) {
+        // Data unchanged since last fetch, the cached copies are fresh
+        http.end();
+        LOG_INFO("Not modified, using cached data");
+        uint8_t cached = min(DataStorage::goalCount(), maxGoals);
+        for (uint8_t i = 0; i < cached; i++) {
+            DataStorage::load(goals[i], i);
+        }
+        count = cached;
+        return count > 0;
+    }
 
-        if (error) {
-            Serial.print("JSON parsing failed: ");
-            Serial.println(error.c_str());
+    if (httpCode == 200) {
+        int contentLength = http.getSize();  // -1 if the server didn't send one
+        if (contentLength > (int)MAX_RESPONSE_SIZE) {
+            LOG_ERROR("Response too large: %d bytes", contentLength);
             http.end();
             return false;
         }
+        bool msgPack = isMsgPack(http.header("Content-Type").c_str());
+        LOG_DEBUG("Response received (%s)", msgPack ? "MessagePack" : "JSON");
 
-        // Extract data
-        data.daysToGoal = doc["projection"]["days_to_target"];
-        data.progressPercent = doc["goal_tracking"]["current_progress_percent"];
+        JsonDocument filter;
+        buildFilter(filter);
 
-        // Extract and format timestamp from metadata
-        const char* timestamp = doc["metadata"]["data_timestamp"];
-        data.lastUpdateTime = formatTimestamp(timestamp);
+        // Parse while the body streams in, it is never buffered as a whole
+        uint32_t heapBefore = ESP.getFreeHeap();
+        unsigned long parseStart = micros();
 
-        data.isValid = true;
+        JsonDocument doc;
+        BoundedStreamReader reader(http.getStream(), MAX_RESPONSE_SIZE);
+        WakeProfiler::start(PHASE_PARSE);
+        DeserializationError error =
+            msgPack ? deserializeMsgPack(doc, reader, DeserializationOption::Filter(filter))
+                    : deserializeJson(doc, reader, DeserializationOption::Filter(filter));
+        WakeProfiler::stop(PHASE_PARSE);
+
+        unsigned long parseTime = micros() - parseStart;
+        LOG_INFO("Parsed %u bytes in %lu us (heap used: %u bytes, min free: %u bytes)",
+                 (unsigned)reader.bytesRead(), parseTime,
+                 (unsigned)(heapBefore - ESP.getFreeHeap()), (unsigned)ESP.getMinFreeHeap());
 
-        Serial.print("Days to goal: ");
-        Serial.println(data.daysToGoal);
-        Serial.print("Progress: ");
-        Serial.print(data.progressPercent);
-        Serial.println("%");
-        Serial.print("Data timestamp: ");
-        Serial.println(data.lastUpdateTime);
+        if (error) {
+            LOG_ERROR("%s parsing failed: %s", msgPack ? "MessagePack" : "JSON",
+                      reader.limitReached() ? "response exceeds size limit" : error.c_str());
+            http.end();
+            return false;
+        }
 
+        count = extractGoals(doc, goals, maxGoals);
+        if (count > 0) {
+            storeValidators(http);
+        }
         http.end();
+        if (count == 0) {
+            LOG_ERROR("No goals in response");
+            return false;
+        }
         return true;
     } else {
-        Serial.print("HTTP error: ");
-        Serial.println(httpCode);
+        LOG_ERROR("HTTP error: %d", httpCode);
         http.end();
         return false;
     }
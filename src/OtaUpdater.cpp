@@ -0,0 +1,257 @@
+#include "OtaUpdater.h"
+#include "Log.h"
+
+// Marks an OtaTrial record as written by this code (RTC memory holds
+// garbage after a power cycle)
+#define OTA_TRIAL_MAGIC 0x4F544131
+// Patch bytes read from the socket at a time
+#define OTA_CHUNK_SIZE 512
+
+// "Bearer <API_TOKEN>" with its terminator, built on the stack
+constexpr size_t OTA_AUTHORIZATION_SIZE = sizeof("Bearer ") + __builtin_strlen(API_TOKEN);
+
+// Initialize static RTC memory variables (not reinitialized on a software reset)
+RTC_NOINIT_ATTR OtaTrial OtaUpdater::rtc_trial;
+
+char OtaUpdater::offerVersion[OTA_VERSION_SIZE] = "";
+char OtaUpdater::offerUrl[OTA_URL_SIZE] = "";
+char OtaUpdater::offerSignature[IMAGE_SIGNATURE_SIZE] = "";
+bool OtaUpdater::ready = false;
+
+// The API server of config.h, unless OTA_ENABLED is off
+const char* OtaUpdater::sourceUrl = OTA_ENABLED ? API_URL : "";
+const char* OtaUpdater::sourcePin = API_CERT_SHA256;
+const char* OtaUpdater::sourceKey = OTA_PUBLIC_KEY;
+
+// Where the patch is applied from and written to
+struct OtaSlots {
+    const esp_partition_t* running;
+    esp_ota_handle_t handle;
+};
+
+void OtaUpdater::begin() {
+    if (OTA_ENABLED && !enabled()) {
+        LOG_WARN("OTA: off, needs an https:// API_URL, API_CERT_SHA256 and OTA_PUBLIC_KEY");
+    }
+    if (!hasTrial() || rtc_trial.state != OTA_TRIAL_PENDING) {
+        return;
+    }
+
+    if (esp_ota_get_running_partition()->address != rtc_trial.partition) {
+        // The bootloader didn't start the new image
+        LOG_ERROR("OTA: firmware %s did not boot", rtc_trial.version);
+        saveTrial(OTA_TRIAL_ROLLED_BACK, rtc_trial.partition, rtc_trial.version);
+        return;
+    }
+
+    if (rtc_trial.wakes < OTA_TRIAL_WAKES) {
+        rtc_trial.wakes++;
+        rtc_trial.crc = crc32(0, (const uint8_t*)&rtc_trial, offsetof(OtaTrial, crc));
+        LOG_INFO("OTA: firmware %s on trial, wake %u of %u", rtc_trial.version,
+                 (unsigned)rtc_trial.wakes, (unsigned)OTA_TRIAL_WAKES);
+        return;
+    }
+
+    // With two app slots the other one still holds the previous image
+    LOG_ERROR("OTA: firmware %s not confirmed, rolling back", rtc_trial.version);
+    saveTrial(OTA_TRIAL_ROLLED_BACK, rtc_trial.partition, rtc_trial.version);
+    Log::flush();
+    if (esp_ota_set_boot_partition(esp_ota_get_next_update_partition(nullptr)) == ESP_OK) {
+        esp_restart();
+    }
+}
+
+void OtaUpdater::confirm() {
+    if (!hasTrial() || rtc_trial.state != OTA_TRIAL_PENDING) {
+        return;
+    }
+    // Also cancels the bootloader's rollback where that is enabled
+    esp_ota_mark_app_valid_cancel_rollback();
+    LOG_INFO("OTA: firmware %s confirmed", rtc_trial.version);
+    rtc_trial.magic = 0;
+}
+
+void OtaUpdater::setSource(const char* apiUrl, const char* certPin, const char* publicKey) {
+    sourceUrl = apiUrl;
+    sourcePin = certPin;
+    sourceKey = publicKey;
+}
+
+bool OtaUpdater::enabled() {
+    // Only over HTTPS with a pinned certificate, and only signed images
+    return strncmp(sourceUrl, "https://", 8) == 0 && sourcePin[0] != '\0' && sourceKey[0] != '\0';
+}
+
+void OtaUpdater::offer(const char* version, const char* url, const char* signature) {
+    offerVersion[0] = '\0';
+    if (!enabled() || !version || !url || strcmp(version, FIRMWARE_VERSION) == 0) {
+        return;
+    }
+    if (!signature) {
+        LOG_WARN("OTA: unsigned offer of %s ignored", version);
+        return;
+    }
+    if (strlen(version) >= OTA_VERSION_SIZE || strlen(url) >= OTA_URL_SIZE ||
+        strlen(signature) >= IMAGE_SIGNATURE_SIZE) {
+        LOG_WARN("OTA: offer too long, ignored");
+        return;
+    }
+    if (hasTrial() && rtc_trial.state == OTA_TRIAL_ROLLED_BACK && strcmp(version, rtc_trial.version) == 0) {
+        LOG_DEBUG("OTA: firmware %s was rolled back, ignored", version);
+        return;
+    }
+    strcpy(offerVersion, version);
+    strcpy(offerUrl, url);
+    strcpy(offerSignature, signature);
+}
+
+bool OtaUpdater::hasOffer() {
+    return offerVersion[0] != '\0';
+}
+
+bool OtaUpdater::updateReady() {
+    return ready;
+}
+
+bool OtaUpdater::apply() {
+    if (!hasOffer()) {
+        return false;
+    }
+    // One attempt per offer and wake
+    char version[OTA_VERSION_SIZE];
+    strcpy(version, offerVersion);
+    offerVersion[0] = '\0';
+
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_partition_t* target = esp_ota_get_next_update_partition(nullptr);
+    if (!target) {
+        LOG_ERROR("OTA: no partition for the update");
+        return false;
+    }
+
+    char url[OTA_URL_SIZE * 2];
+    if (!buildUrl(url, sizeof(url))) {
+        LOG_ERROR("OTA: patch URL is not on the API server, ignored");
+        return false;
+    }
+    LOG_INFO("OTA: updating %s to %s", FIRMWARE_VERSION, version);
+    unsigned long startMs = millis();
+
+    // Declared first so it outlives the HTTPClient using it
+    TlsClient tls;
+    HTTPClient http;
+    http.useHTTP10(true);
+    http.begin(tls, url);
+    // buildUrl keeps the token on the API server
+    char authorization[OTA_AUTHORIZATION_SIZE];
+    snprintf(authorization, sizeof(authorization), "Bearer %s", API_TOKEN);
+    http.addHeader("Authorization", authorization);
+    http.setTimeout(10000);
+
+    int httpCode = http.GET();
+    if (httpCode != 200) {
+        LOG_ERROR("OTA: patch download failed: %d", httpCode);
+        http.end();
+        return false;
+    }
+
+    // The slot is erased sector by sector as the new image is written
+    OtaSlots slots = {running, 0};
+    if (esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &slots.handle) != ESP_OK) {
+        LOG_ERROR("OTA: cannot write the update partition");
+        http.end();
+        return false;
+    }
+    DeltaPatch patch(readRunning, writeUpdate, &slots);
+    ImageSignature::begin();
+    DeltaPatch::Result result = download(http, patch);
+    http.end();
+
+    if (result != DeltaPatch::PATCH_DONE) {
+        LOG_ERROR("OTA: %s", result == DeltaPatch::PATCH_ERROR ? patch.error() : "patch incomplete");
+        esp_ota_abort(slots.handle);
+        return false;
+    }
+    // The CRCs only catch damage, the signature proves where it came from
+    if (!ImageSignature::verify(offerSignature, sourceKey)) {
+        LOG_ERROR("OTA: image signature invalid, %s rejected", version);
+        esp_ota_abort(slots.handle);
+        return false;
+    }
+    // esp_ota_end checks the image (header and hash) before it may boot
+    if (esp_ota_end(slots.handle) != ESP_OK || esp_ota_set_boot_partition(target) != ESP_OK) {
+        LOG_ERROR("OTA: new image rejected");
+        return false;
+    }
+
+    saveTrial(OTA_TRIAL_PENDING, target->address, version);
+    ready = true;
+    LOG_INFO("OTA: %u byte image written in %lu ms, restarting", (unsigned)patch.newSize(),
+             millis() - startMs);
+    return true;
+}
+
+DeltaPatch::Result OtaUpdater::download(HTTPClient& http, DeltaPatch& patch) {
+    // Patch bytes are applied as they arrive, nothing is buffered
+    Stream& stream = http.getStream();
+    int remaining = http.getSize();  // -1 if the server didn't send one
+    uint8_t chunk[OTA_CHUNK_SIZE];
+    unsigned long startMs = millis();
+    DeltaPatch::Result result = DeltaPatch::PATCH_MORE;
+    while (result == DeltaPatch::PATCH_MORE && remaining != 0 && millis() - startMs < OTA_TIMEOUT) {
+        size_t wanted = remaining > 0 ? min((size_t)remaining, sizeof(chunk)) : sizeof(chunk);
+        size_t n = stream.readBytes((char*)chunk, wanted);
+        if (n == 0) {
+            break;  // closed or timed out
+        }
+        if (remaining > 0) {
+            remaining -= n;
+        }
+        result = patch.feed(chunk, n);
+    }
+    return result;
+}
+
+bool OtaUpdater::readRunning(void* context, uint32_t offset, uint8_t* buffer, size_t size) {
+    const OtaSlots* slots = (const OtaSlots*)context;
+    return esp_partition_read(slots->running, offset, buffer, size) == ESP_OK;
+}
+
+bool OtaUpdater::writeUpdate(void* context, const uint8_t* bytes, size_t size) {
+    const OtaSlots* slots = (const OtaSlots*)context;
+    ImageSignature::update(bytes, size);
+    return esp_ota_write(slots->handle, bytes, size) == ESP_OK;
+}
+
+bool OtaUpdater::buildUrl(char* url, size_t size) {
+    // Patches only come from the API server: a path is relative to it, a
+    // full URL has to be on it
+    const char* host = strstr(sourceUrl, "://");
+    const char* path = host ? strchr(host + 3, '/') : nullptr;
+    int originLength = path ? (int)(path - sourceUrl) : (int)strlen(sourceUrl);
+    if (strstr(offerUrl, "://")) {
+        if (strncmp(offerUrl, sourceUrl, originLength) != 0 || offerUrl[originLength] != '/') {
+            return false;
+        }
+        snprintf(url, size, "%s", offerUrl);
+        return true;
+    }
+    snprintf(url, size, "%.*s%s%s", originLength, sourceUrl, offerUrl[0] == '/' ? "" : "/", offerUrl);
+    return true;
+}
+
+void OtaUpdater::saveTrial(OtaTrialState state, uint32_t partition, const char* version) {
+    OtaTrial trial = {};
+    trial.magic = OTA_TRIAL_MAGIC;
+    trial.state = state;
+    trial.wakes = 0;
+    trial.partition = partition;
+    strncpy(trial.version, version, OTA_VERSION_SIZE - 1);
+    trial.crc = crc32(0, (const uint8_t*)&trial, offsetof(OtaTrial, crc));
+    rtc_trial = trial;
+}
+
+bool OtaUpdater::hasTrial() {
+    return rtc_trial.magic == OTA_TRIAL_MAGIC &&
+           rtc_trial.crc == crc32(0, (const uint8_t*)&rtc_trial, offsetof(OtaTrial, crc));
+}
@@ -0,0 +1,178 @@
+#include "TimeKeeper.h"
+#include "Log.h"
+#include <sys/time.h>
+#include <esp_sntp.h>
+
+// Anything before this is an unset clock (1970 + a few days)
+#define MIN_VALID_EPOCH 100000
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR time_t TimeKeeper::rtc_lastSyncEpoch = 0;
+RTC_DATA_ATTR time_t TimeKeeper::rtc_sleepStartEpoch = 0;
+RTC_DATA_ATTR uint32_t TimeKeeper::rtc_sleepSeconds = 0;
+RTC_DATA_ATTR uint16_t TimeKeeper::rtc_wakesSinceSync = 0;
+
+bool TimeKeeper::syncStarted = false;
+unsigned long TimeKeeper::syncStartMs = 0;
+volatile unsigned long TimeKeeper::syncDoneMs = 0;
+
+void TimeKeeper::restore() {
+    if (rtc_wakesSinceSync < UINT16_MAX) {
+        rtc_wakesSinceSync++;
+    }
+
+    // The system clock normally keeps running on the RTC timer during deep
+    // sleep. If it was lost, estimate it from when we went to sleep.
+    if (!isTimeValid() && rtc_sleepStartEpoch >= MIN_VALID_EPOCH) {
+        timeval tv{};
+        tv.tv_sec = rtc_sleepStartEpoch + rtc_sleepSeconds + millis() / 1000;
+        settimeofday(&tv, nullptr);
+        LOG_DEBUG("Clock restored from sleep duration");
+    }
+
+    if (isTimeValid()) {
+        LOG_INFO("Clock: %u wakes since NTP sync, estimated drift %lu s",
+                 rtc_wakesSinceSync, (unsigned long)estimatedDrift());
+    }
+}
+
+bool TimeKeeper::isTimeValid() {
+    return time(nullptr) >= MIN_VALID_EPOCH;
+}
+
+bool TimeKeeper::needsSync() {
+    return !isTimeValid() ||
+           rtc_lastSyncEpoch < MIN_VALID_EPOCH ||
+           rtc_wakesSinceSync >= NTP_SYNC_EVERY_WAKES ||
+           estimatedDrift() > MAX_CLOCK_DRIFT;
+}
+
+void TimeKeeper::beginSync() {
+    LOG_DEBUG("Starting NTP sync in background...");
+    // configTime only starts SNTP, the request runs in the network stack
+    // while we carry on with the HTTP fetch
+    WakeProfiler::start(PHASE_NTP);
+    syncStartMs = millis();
+    syncDoneMs = 0;
+    sntp_set_time_sync_notification_cb(onTimeSync);
+    configTime(TIMEZONE_OFFSET, 0, "pool.ntp.org", "time.nist.gov");
+    syncStarted = true;
+}
+
+void TimeKeeper::onTimeSync(struct timeval*) {
+    // Runs in the network stack: the latency sample for AdaptiveTimeout,
+    // which finishSync may only see long after
+    syncDoneMs = millis();
+}
+
+bool TimeKeeper::finishSync(unsigned long timeoutMs) {
+    if (!syncStarted) {
+        return false;
+    }
+
+    // Wait for the remainder of the sync (usually already done by now)
+    // (COMPLETED is only reported once, so keep the status we saw)
+    sntp_sync_status_t status = sntp_get_sync_status();
+    while (status != SNTP_SYNC_STATUS_COMPLETED && millis() - syncStartMs < timeoutMs) {
+        delay(50);
+        status = sntp_get_sync_status();
+    }
+    syncStarted = false;
+    WakeProfiler::stop(PHASE_NTP);
+
+    if (status == SNTP_SYNC_STATUS_COMPLETED && isTimeValid()) {
+        AdaptiveTimeout::record(TIMEOUT_NTP, (syncDoneMs != 0 ? syncDoneMs : millis()) - syncStartMs);
+        rtc_lastSyncEpoch = time(nullptr);
+        rtc_wakesSinceSync = 0;
+        LOG_INFO("Time synchronized!");
+        return true;
+    }
+
+    LOG_WARN("Time sync failed, using RTC clock");
+    AdaptiveTimeout::recordTimeout(TIMEOUT_NTP);
+    return false;
+}
+
+void TimeKeeper::prepareSleep(uint32_t sleepSeconds) {
+    rtc_sleepStartEpoch = isTimeValid() ? time(nullptr) : 0;
+    rtc_sleepSeconds = sleepSeconds;
+}
+
+// Reads a fixed number of digits and the separator after them (none if 0);
+// stops at the first unexpected character, so it never reads past the end
+static bool readField(const char*& text, int digits, char separator, int& value) {
+    value = 0;
+    for (int i = 0; i < digits; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    text += digits;
+    if (separator != '\0') {
+        if (*text != separator) {
+            return false;
+        }
+        text++;
+    }
+    return true;
+}
+
+time_t TimeKeeper::parseIsoTime(const char* isoTimestamp) {
+    // UTC timestamp such as "2025-10-28T11:51:53.666Z"; returns 0 if invalid.
+    // Parsed by hand rather than with sscanf, which is slower and may use the
+    // heap. Fractions and the zone suffix are ignored.
+    int year, month, day, hour, minute, second;
+    const char* text = isoTimestamp;
+    if (!text || !readField(text, 4, '-', year) || !readField(text, 2, '-', month) ||
+        !readField(text, 2, 'T', day) || !readField(text, 2, ':', hour) ||
+        !readField(text, 2, ':', minute) || !readField(text, 2, '\0', second) ||
+        month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return 0;
+    }
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar (no mktime,
+    // which would apply the local timezone)
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    long days = era * 146097 + dayOfEra - 719468;
+
+    return (time_t)days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+size_t TimeKeeper::formatLocal(time_t epoch, const char* format, char* buffer, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    if (epoch == 0) {
+        strncpy(buffer, "N/A", size - 1);
+        buffer[size - 1] = '\0';
+        return strlen(buffer);
+    }
+    // TIMEZONE_OFFSET is fixed, so local time is UTC shifted by it. gmtime_r
+    // skips the TZ handling of localtime_r (newlib's tzset allocates).
+    time_t local = epoch + TIMEZONE_OFFSET;
+    struct tm fields;
+    gmtime_r(&local, &fields);
+    size_t length = strftime(buffer, size, format, &fields);
+    if (length == 0) {
+        buffer[0] = '\0';
+    }
+    return length;
+}
+
+int32_t TimeKeeper::localDay(time_t epoch) {
+    int64_t local = (int64_t)epoch + TIMEZONE_OFFSET;
+    return (int32_t)(local >= 0 ? local / 86400 : (local - 86399) / 86400);
+}
+
+uint32_t TimeKeeper::estimatedDrift() {
+    if (rtc_lastSyncEpoch < MIN_VALID_EPOCH || !isTimeValid()) {
+        return UINT32_MAX;
+    }
+    uint64_t elapsed = (uint64_t)(time(nullptr) - rtc_lastSyncEpoch);
+    return (uint32_t)(elapsed * RTC_DRIFT_PPM / 1000000ULL);
+}
@@ -0,0 +1,387 @@
+#include "TlsClient.h"
+#include "Log.h"
+#include <esp_random.h>
+#include <mbedtls/version.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/net_sockets.h>
+
+// TCP connect limit (cut to the wake's time budget); the handshake's is
+// learned, see AdaptiveTimeout
+#define TLS_TIMEOUT 10000
+
+static_assert(TLS_SESSION_SIZE <= UINT16_MAX, "TLS_SESSION_SIZE must fit in 16 bits");
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR uint8_t TlsClient::rtc_session[TLS_SESSION_SIZE] = {0};
+RTC_DATA_ATTR uint16_t TlsClient::rtc_sessionLength = 0;
+RTC_DATA_ATTR uint32_t TlsClient::rtc_sessionHost = 0;
+RTC_DATA_ATTR uint16_t TlsClient::rtc_fullHandshakes = 0;
+RTC_DATA_ATTR uint16_t TlsClient::rtc_resumedHandshakes = 0;
+
+// State of the open connection
+static mbedtls_ssl_context tlsContext;
+static mbedtls_ssl_config tlsConfig;
+static bool tlsReady = false;         // contexts initialized
+static bool tlsOpen = false;          // handshake done, not closed by the peer
+static int peeked = -1;
+static uint8_t pinnedDigest[32];
+static bool certificateSeen = false;
+static bool pinMatched = false;
+
+static void logTlsError(const char* what, int ret) {
+    LOG_ERROR("%s: -0x%04X", what, (unsigned)-ret);
+}
+
+static int randomBytes(void* ctx, unsigned char* output, size_t length) {
+    // Hardware RNG (true random while the radio is on)
+    esp_fill_random(output, length);
+    return 0;
+}
+
+// Transport callbacks: the TCP socket is the WiFiClient base of the TlsClient
+static int sendBytes(void* ctx, const unsigned char* buf, size_t length) {
+    size_t n = static_cast<TlsClient*>(ctx)->WiFiClient::write(buf, length);
+    return n > 0 ? (int)n : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int receiveBytes(void* ctx, unsigned char* buf, size_t length) {
+    TlsClient* socket = static_cast<TlsClient*>(ctx);
+    if (socket->WiFiClient::available() <= 0) {
+        return socket->WiFiClient::connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    int n = socket->WiFiClient::read(buf, length);
+    return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+static void sha256(const uint8_t* data, size_t length, uint8_t* digest) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_sha256(data, length, digest, 0);
+#else
+    mbedtls_sha256_ret(data, length, digest, 0);
+#endif
+}
+
+// Called for each certificate of a full handshake. There is no CA chain,
+// trust comes from the pinned server certificate alone.
+static int verifyCertificate(void* ctx, mbedtls_x509_crt* crt, int depth, uint32_t* flags) {
+    if (depth == 0) {
+        uint8_t digest[32];
+        sha256(crt->raw.p, crt->raw.len, digest);
+        certificateSeen = true;
+        pinMatched = memcmp(digest, pinnedDigest, sizeof(digest)) == 0;
+        if (!pinMatched) {
+            return MBEDTLS_ERR_X509_FATAL_ERROR;
+        }
+    }
+    *flags = 0;
+    return 0;
+}
+
+TlsClient::~TlsClient() {
+    stop();
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port, TLS_TIMEOUT);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    return connect(ip.toString().c_str(), port, timeout);
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, TLS_TIMEOUT);
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    stop();
+    unsigned long start = millis();
+    if (!WiFiClient::connect(host, port, (int32_t)CircuitBreaker::limitTimeout(timeout))) {
+        return 0;
+    }
+    if (!handshake(host, port)) {
+        stop();
+        return 0;
+    }
+    connectMs = millis() - start;
+    return 1;
+}
+
+bool TlsClient::handshake(const char* host, uint16_t port) {
+    if (!parsePin(pinnedDigest)) {
+        LOG_ERROR("API_CERT_SHA256 is not a SHA-256 fingerprint, not connecting");
+        return false;
+    }
+
+    mbedtls_ssl_init(&tlsContext);
+    mbedtls_ssl_config_init(&tlsConfig);
+    tlsReady = true;
+    peeked = -1;
+    certificateSeen = false;
+    pinMatched = false;
+
+    int ret = mbedtls_ssl_config_defaults(&tlsConfig, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        logTlsError("TLS setup failed", ret);
+        return false;
+    }
+    // OPTIONAL: mbedTLS would insist on a CA chain otherwise, the pin is
+    // enforced in verifyCertificate
+    mbedtls_ssl_conf_authmode(&tlsConfig, MBEDTLS_SSL_VERIFY_OPTIONAL);
+    mbedtls_ssl_conf_verify(&tlsConfig, verifyCertificate, nullptr);
+    mbedtls_ssl_conf_rng(&tlsConfig, randomBytes, nullptr);
+    // TLS 1.2 sessions can be stored and resumed with session IDs or tickets
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_ssl_conf_max_tls_version(&tlsConfig, MBEDTLS_SSL_VERSION_TLS1_2);
+#else
+    mbedtls_ssl_conf_max_version(&tlsConfig, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&tlsConfig, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    ret = mbedtls_ssl_setup(&tlsContext, &tlsConfig);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_hostname(&tlsContext, host);
+    }
+    if (ret != 0) {
+        logTlsError("TLS setup failed", ret);
+        return false;
+    }
+    mbedtls_ssl_set_bio(&tlsContext, this, sendBytes, receiveBytes, nullptr);
+
+    // Offer the stored session if it belongs to this server
+    uint32_t hostHash = hashHost(host, port);
+    bool offered = false;
+    if (rtc_sessionLength > 0 && rtc_sessionHost == hostHash) {
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        offered = mbedtls_ssl_session_load(&session, rtc_session, rtc_sessionLength) == 0 &&
+                  mbedtls_ssl_set_session(&tlsContext, &session) == 0;
+        mbedtls_ssl_session_free(&session);
+        if (!offered) {
+            LOG_WARN("Stored TLS session unusable, discarding it");
+            clearSession();
+        }
+    }
+
+    // A resumption the server turns down becomes a full handshake: that
+    // shows with its Certificate message
+    unsigned long start = millis();
+    TimeoutPhase phase = offered ? TIMEOUT_TLS_RESUMED : TIMEOUT_TLS_FULL;
+    unsigned long timeoutMs = CircuitBreaker::limitTimeout(AdaptiveTimeout::get(phase));
+    while ((ret = mbedtls_ssl_handshake(&tlsContext)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (certificateSeen && !pinMatched) {
+                LOG_ERROR("Server certificate doesn't match API_CERT_SHA256");
+            } else {
+                logTlsError("TLS handshake failed", ret);
+            }
+            clearSession();
+            return false;
+        }
+        if (phase == TIMEOUT_TLS_RESUMED && certificateSeen) {
+            phase = TIMEOUT_TLS_FULL;
+            timeoutMs = CircuitBreaker::limitTimeout(AdaptiveTimeout::get(phase));
+        }
+        if (millis() - start >= timeoutMs) {
+            // The stored session is still good, only the network was slow
+            LOG_WARN("TLS handshake timed out after %lu ms", timeoutMs);
+            AdaptiveTimeout::recordTimeout(phase);
+            return false;
+        }
+        delay(1);
+    }
+    unsigned long handshakeMs = millis() - start;
+
+    // A resumed handshake has no Certificate message
+    bool resumed = offered && !certificateSeen;
+    if (!resumed && !pinMatched) {
+        LOG_ERROR("Server certificate not verified, closing");
+        clearSession();
+        return false;
+    }
+
+    tlsOpen = true;
+    AdaptiveTimeout::record(resumed ? TIMEOUT_TLS_RESUMED : TIMEOUT_TLS_FULL, handshakeMs);
+    if (resumed) {
+        rtc_resumedHandshakes++;
+    } else {
+        rtc_fullHandshakes++;
+    }
+    LOG_INFO("TLS handshake (%s) in %lu ms, %u full / %u resumed since power-on",
+             resumed ? "resumed" : "full", handshakeMs,
+             (unsigned)rtc_fullHandshakes, (unsigned)rtc_resumedHandshakes);
+
+    // The server may have issued a new ticket, store the session every time
+    saveSession(hostHash);
+    return true;
+}
+
+void TlsClient::saveSession(uint32_t hostHash) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t length = 0;
+    int ret = mbedtls_ssl_get_session(&tlsContext, &session);
+    if (ret == 0) {
+        ret = mbedtls_ssl_session_save(&session, rtc_session, sizeof(rtc_session), &length);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    if (ret == 0) {
+        rtc_sessionLength = (uint16_t)length;
+        rtc_sessionHost = hostHash;
+        return;
+    }
+    if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        LOG_WARN("TLS session needs %u bytes, more than TLS_SESSION_SIZE", (unsigned)length);
+    } else {
+        logTlsError("TLS session not stored", ret);
+    }
+    clearSession();
+}
+
+void TlsClient::clearSession() {
+    rtc_sessionLength = 0;
+    rtc_sessionHost = 0;
+}
+
+uint32_t TlsClient::hashHost(const char* host, uint16_t port) {
+    // FNV-1a of host and port
+    uint32_t hash = 2166136261u;
+    for (const char* c = host; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    hash = (hash ^ (port & 0xFF)) * 16777619u;
+    hash = (hash ^ (port >> 8)) * 16777619u;
+    return hash;
+}
+
+bool TlsClient::parsePin(uint8_t* pin) {
+    // 64 hex digits, colons and spaces between them are ignored
+    size_t digits = 0;
+    for (const char* c = API_CERT_SHA256; *c; c++) {
+        if (*c == ':' || *c == ' ') {
+            continue;
+        }
+        if (!isxdigit((unsigned char)*c) || digits == 64) {
+            return false;
+        }
+        uint8_t value = isdigit((unsigned char)*c) ? *c - '0' : (tolower((unsigned char)*c) - 'a' + 10);
+        pin[digits / 2] = (digits % 2) ? (pin[digits / 2] | value) : (value << 4);
+        digits++;
+    }
+    return digits == 64;
+}
+
+size_t TlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    if (!tlsOpen) {
+        return 0;
+    }
+    size_t written = 0;
+    unsigned long start = millis();
+    while (written < size && millis() - start < TLS_TIMEOUT) {
+        int ret = mbedtls_ssl_write(&tlsContext, buf + written, size - written);
+        if (ret > 0) {
+            written += ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            logTlsError("TLS write failed", ret);
+            break;
+        } else {
+            delay(1);
+        }
+    }
+    return written;
+}
+
+int TlsClient::available() {
+    if (!tlsOpen) {
+        return peeked >= 0 ? 1 : 0;
+    }
+    // A zero-length read decrypts the next record if it has arrived
+    int ret = mbedtls_ssl_read(&tlsContext, nullptr, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        // close_notify or a broken connection
+        tlsOpen = false;
+        return peeked >= 0 ? 1 : 0;
+    }
+    return (int)mbedtls_ssl_get_bytes_avail(&tlsContext) + (peeked >= 0 ? 1 : 0);
+}
+
+int TlsClient::read() {
+    // WANT_READ only means the next record hasn't arrived; the streaming
+    // parsers would take -1 as the end of the body, so wait for it up to
+    // the stream timeout like WiFiClient's blocking socket does
+    uint8_t c;
+    unsigned long start = millis();
+    while (read(&c, 1) != 1) {
+        if (!tlsOpen || millis() - start >= getTimeout()) {
+            return -1;
+        }
+        delay(1);
+    }
+    return c;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t n = 0;
+    if (peeked >= 0) {
+        buf[n++] = (uint8_t)peeked;
+        peeked = -1;
+    }
+    if (n < size && tlsOpen) {
+        int ret = mbedtls_ssl_read(&tlsContext, buf + n, size - n);
+        if (ret > 0) {
+            n += ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            tlsOpen = false;
+        }
+    }
+    return n > 0 ? (int)n : -1;
+}
+
+int TlsClient::peek() {
+    uint8_t c;
+    if (peeked < 0 && read(&c, 1) == 1) {
+        peeked = c;
+    }
+    return peeked;
+}
+
+void TlsClient::flush() {
+    // Nothing buffered for sending (WiFiClient::flush would drop received data)
+}
+
+void TlsClient::stop() {
+    if (tlsOpen) {
+        // A cleanly closed session stays resumable on the server
+        mbedtls_ssl_close_notify(&tlsContext);
+    }
+    if (tlsReady) {
+        mbedtls_ssl_free(&tlsContext);
+        mbedtls_ssl_config_free(&tlsConfig);
+        tlsReady = false;
+    }
+    tlsOpen = false;
+    peeked = -1;
+    WiFiClient::stop();
+}
+
+uint8_t TlsClient::connected() {
+    if (peeked >= 0) {
+        return 1;
+    }
+    if (!tlsOpen) {
+        return 0;
+    }
+    return mbedtls_ssl_get_bytes_avail(&tlsContext) > 0 || WiFiClient::connected();
+}
@@ -0,0 +1,85 @@
+#include "WakeProfiler.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <esp_sleep.h>
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR WakeRecord WakeProfiler::rtc_records[WAKE_PROFILE_HISTORY] = {};
+RTC_DATA_ATTR uint8_t WakeProfiler::rtc_head = 0;
+RTC_DATA_ATTR uint8_t WakeProfiler::rtc_count = 0;
+
+WakeRecord WakeProfiler::current = {};
+int64_t WakeProfiler::phaseStart[PHASE_COUNT] = {0};
+
+void WakeProfiler::begin() {
+    current = {};
+    current.resetReason = (uint8_t)esp_reset_reason();
+    current.wakeCause = (uint8_t)esp_sleep_get_wakeup_cause();
+    current.rssi = 0;
+
+    // Boot phase is everything from reset until setup() starts
+    current.phaseMs[PHASE_BOOT] = (uint16_t)(esp_timer_get_time() / 1000);
+}
+
+void WakeProfiler::start(WakePhase phase) {
+    phaseStart[phase] = esp_timer_get_time();
+}
+
+void WakeProfiler::stop(WakePhase phase) {
+    if (phaseStart[phase] == 0) {
+        return;
+    }
+    // Phases can run more than once per wake (e.g. two scans), so accumulate
+    uint32_t total = current.phaseMs[phase] + (uint32_t)((esp_timer_get_time() - phaseStart[phase]) / 1000);
+    current.phaseMs[phase] = total > UINT16_MAX ? UINT16_MAX : (uint16_t)total;
+    phaseStart[phase] = 0;
+}
+
+void WakeProfiler::setRssi(int8_t rssi) {
+    current.rssi = rssi;
+}
+
+void WakeProfiler::commit() {
+    uint32_t heapKb = ESP.getMinFreeHeap() / 1024;
+    current.minFreeHeapKb = heapKb > UINT16_MAX ? UINT16_MAX : (uint16_t)heapKb;
+
+    // Oldest record is overwritten once the ring is full
+    rtc_records[rtc_head] = current;
+    rtc_head = (rtc_head + 1) % WAKE_PROFILE_HISTORY;
+    if (rtc_count < WAKE_PROFILE_HISTORY) {
+        rtc_count++;
+    }
+}
+
+bool WakeProfiler::hasPending() {
+    return rtc_count > 0;
+}
+
+size_t WakeProfiler::formatPending(char* buffer, size_t size) {
+    // Compact text encoding, oldest record first:
+    //   1;<reset>,<wake>,<rssi>,<heapKb>,<boot>.<display>.<scan>...|<next record>
+    size_t len = snprintf(buffer, size, "1;");
+    uint8_t first = (rtc_head + WAKE_PROFILE_HISTORY - rtc_count) % WAKE_PROFILE_HISTORY;
+
+    for (uint8_t i = 0; i < rtc_count && len < size; i++) {
+        const WakeRecord& record = rtc_records[(first + i) % WAKE_PROFILE_HISTORY];
+        len += snprintf(buffer + len, size - len, "%s%u,%u,%d,%u,",
+                        i > 0 ? "|" : "", record.resetReason, record.wakeCause,
+                        record.rssi, record.minFreeHeapKb);
+        for (uint8_t phase = 0; phase < PHASE_COUNT && len < size; phase++) {
+            len += snprintf(buffer + len, size - len, phase > 0 ? ".%u" : "%u",
+                            record.phaseMs[phase]);
+        }
+    }
+
+    if (len >= size) {
+        // Never send a cut-off record
+        buffer[0] = '\0';
+        return 0;
+    }
+    return len;
+}
+
+void WakeProfiler::clearPending() {
+    rtc_count = 0;
+}
@@ -0,0 +1,218 @@
+#include "WakeScheduler.h"
+#include "Log.h"
+
+// Shortest sleep a server hint can ask for (seconds)
+#define MIN_HINT_SECONDS 60
+
+// Longest fetch backoff while fetches fail, as a power of two of FETCH_EVERY_WAKES
+#define MAX_FETCH_BACKOFF_SHIFT 3
+
+// Local updates wake this long after midnight, so RTC drift can't make the
+// wake land just before the day changes (seconds)
+#define DAY_CHANGE_MARGIN 120
+
+// Initialize static RTC memory variables
+RTC_DATA_ATTR ChangeRecord WakeScheduler::rtc_history[CHANGE_HISTORY] = {};
+RTC_DATA_ATTR uint8_t WakeScheduler::rtc_historyCount = 0;
+RTC_DATA_ATTR uint8_t WakeScheduler::rtc_historyHead = 0;
+RTC_DATA_ATTR uint32_t WakeScheduler::rtc_secondsSinceFetch = 0;
+RTC_DATA_ATTR int32_t WakeScheduler::rtc_lastDays = 0;
+RTC_DATA_ATTR int16_t WakeScheduler::rtc_lastProgressTenths = 0;
+RTC_DATA_ATTR bool WakeScheduler::rtc_hasLast = false;
+RTC_DATA_ATTR uint8_t WakeScheduler::rtc_wakesSinceAttempt = 0;
+RTC_DATA_ATTR uint32_t WakeScheduler::rtc_serverUpdateEpoch = 0;
+
+bool WakeScheduler::fetchedThisWake = false;
+uint32_t WakeScheduler::hintSeconds = 0;
+
+void WakeScheduler::beginWake() {
+    fetchedThisWake = false;
+    hintSeconds = 0;
+}
+
+bool WakeScheduler::fetchDue() {
+    // Without local updates a single goal is fetched on every wake
+    if (GOAL_COUNT == 1 && !localUpdates()) {
+        return true;
+    }
+
+    if (rtc_wakesSinceAttempt < UINT8_MAX) {
+        rtc_wakesSinceAttempt++;
+    }
+
+    bool due;
+    uint16_t every = FETCH_EVERY_WAKES;
+    if (CircuitBreaker::failedWakes() == 0 && rtc_serverUpdateEpoch != 0 &&
+        TimeKeeper::isTimeValid() && (uint32_t)time(nullptr) >= rtc_serverUpdateEpoch) {
+        // The server announced new data by now
+        LOG_INFO("Server update time reached, fetching");
+        due = true;
+    } else if (CircuitBreaker::failedWakes() > 0 || !localUpdates()) {
+        // While fetches fail, try less often (planSleep already spaces the
+        // wakes of a single goal)
+        uint8_t shift = (uint8_t)min(CircuitBreaker::failedWakes(), (uint16_t)MAX_FETCH_BACKOFF_SHIFT);
+        every = GOAL_COUNT == 1 ? 1 : every << shift;
+        due = rtc_wakesSinceAttempt >= every;
+    } else {
+        // Local update until the cached data is FETCH_INTERVAL old
+        due = rtc_secondsSinceFetch >= FETCH_INTERVAL / 1000;
+    }
+
+    if (due) {
+        rtc_wakesSinceAttempt = 0;
+        return true;
+    }
+
+    LOG_INFO("Fetch not due (wake %u, %lu s since the last fetch), showing cached data",
+             rtc_wakesSinceAttempt, (unsigned long)rtc_secondsSinceFetch);
+    return false;
+}
+
+void WakeScheduler::recordFetch(const GoalData& data) {
+    // Compare at the precision shown on screen
+    int16_t progressTenths = (int16_t)lroundf(data.progressPercent * 10.0f);
+    bool changed = data.daysToGoal != rtc_lastDays || progressTenths != rtc_lastProgressTenths;
+
+    if (rtc_hasLast) {
+        ChangeRecord& record = rtc_history[rtc_historyHead];
+        record.minutes = (uint16_t)min(rtc_secondsSinceFetch / 60, (uint32_t)UINT16_MAX);
+        record.changed = changed;
+        rtc_historyHead = (rtc_historyHead + 1) % CHANGE_HISTORY;
+        if (rtc_historyCount < CHANGE_HISTORY) {
+            rtc_historyCount++;
+        }
+    }
+
+    rtc_lastDays = data.daysToGoal;
+    rtc_lastProgressTenths = progressTenths;
+    rtc_hasLast = true;
+    rtc_secondsSinceFetch = 0;
+    rtc_wakesSinceAttempt = 0;
+    fetchedThisWake = true;
+
+    // An announced update time this fetch has caught up with is spent
+    if (rtc_serverUpdateEpoch != 0 && TimeKeeper::isTimeValid() &&
+        (uint32_t)time(nullptr) >= rtc_serverUpdateEpoch) {
+        rtc_serverUpdateEpoch = 0;
+    }
+}
+
+void WakeScheduler::setServerHint(uint32_t seconds) {
+    hintSeconds = seconds;
+    if (TimeKeeper::isTimeValid()) {
+        rtc_serverUpdateEpoch = (uint32_t)time(nullptr) + seconds;
+    }
+    LOG_INFO("Server suggests next update in %lu s", (unsigned long)seconds);
+}
+
+uint32_t WakeScheduler::planSleep() {
+    uint32_t minSeconds = UPDATE_INTERVAL / 1000;
+    uint32_t maxSeconds = max(MAX_UPDATE_INTERVAL / 1000, (unsigned long)minSeconds);
+    uint32_t seconds;
+
+    if (GOAL_COUNT > 1) {
+        // One page per wake: keep turning pages every UPDATE_INTERVAL, sooner
+        // if the server expects new data before then. Fetches are spaced in
+        // wakes by fetchDue() instead.
+        uint32_t untilUpdate = hintSeconds;
+        if (untilUpdate == 0 && rtc_serverUpdateEpoch != 0 && TimeKeeper::isTimeValid() &&
+            rtc_serverUpdateEpoch > (uint32_t)time(nullptr)) {
+            untilUpdate = rtc_serverUpdateEpoch - (uint32_t)time(nullptr);
+        }
+        seconds = untilUpdate > 0 ? constrain(untilUpdate, (uint32_t)MIN_HINT_SECONDS, minSeconds)
+                                  : minSeconds;
+    } else if (hintSeconds > 0) {
+        // The server knows when its data changes next
+        seconds = constrain(hintSeconds, (uint32_t)MIN_HINT_SECONDS, maxSeconds);
+    } else if (localUpdates() && CircuitBreaker::failedWakes() == 0) {
+        // Nothing to fetch until the data is FETCH_INTERVAL old or the
+        // server's announced update time; the day change is handled below
+        uint32_t interval = FETCH_INTERVAL / 1000;
+        seconds = max(interval - min(rtc_secondsSinceFetch, interval), minSeconds);
+        if (rtc_serverUpdateEpoch > (uint32_t)time(nullptr)) {
+            seconds = min(seconds, max(rtc_serverUpdateEpoch - (uint32_t)time(nullptr),
+                                       (uint32_t)MIN_HINT_SECONDS));
+        }
+    } else if (ADAPTIVE_SCHEDULE && fetchedThisWake) {
+        seconds = constrain(adaptiveInterval(), minSeconds, maxSeconds);
+    } else {
+        // Fixed schedule, or this wake's fetch failed: back off while the
+        // failures last
+        seconds = CircuitBreaker::backoffSeconds(minSeconds);
+    }
+
+    if (localUpdates()) {
+        seconds = untilDayChange(seconds);
+    }
+    seconds = skipQuietHours(seconds);
+    rtc_secondsSinceFetch += seconds;
+    return seconds;
+}
+
+bool WakeScheduler::localUpdates() {
+    // The countdown needs the clock
+    return FETCH_INTERVAL > 0 && TimeKeeper::isTimeValid();
+}
+
+uint32_t WakeScheduler::untilDayChange(uint32_t seconds) {
+    // Wake just after local midnight if the sleep would cross it, so the
+    // days left tick down on the day
+    time_t now = time(nullptr);
+    uint32_t untilMidnight = (uint32_t)((int64_t)(TimeKeeper::localDay(now) + 1) * 86400 -
+                                        TIMEZONE_OFFSET - now);
+    if (seconds <= untilMidnight + DAY_CHANGE_MARGIN) {
+        return seconds;
+    }
+    return untilMidnight + DAY_CHANGE_MARGIN;
+}
+
+uint32_t WakeScheduler::adaptiveInterval() {
+    if (rtc_historyCount == 0) {
+        return 0;
+    }
+
+    // Changes come in bursts: look again soon after one
+    uint8_t newest = (rtc_historyHead + CHANGE_HISTORY - 1) % CHANGE_HISTORY;
+    if (rtc_history[newest].changed) {
+        return 0;
+    }
+
+    // Half the mean time between changes seen in the history. Without a
+    // change in the whole window the observed span is a lower bound, so the
+    // interval keeps growing while nothing moves.
+    uint32_t observed = 0;
+    uint32_t changes = 0;
+    for (uint8_t i = 0; i < rtc_historyCount; i++) {
+        observed += rtc_history[i].minutes * 60UL;
+        changes += rtc_history[i].changed ? 1 : 0;
+    }
+    return observed / max(changes, (uint32_t)1) / 2;
+}
+
+uint32_t WakeScheduler::skipQuietHours(uint32_t seconds) {
+    if (QUIET_HOURS_START == QUIET_HOURS_END || !TimeKeeper::isTimeValid()) {
+        return seconds;
+    }
+
+    // Local time of day of the planned wake (TIMEZONE_OFFSET is fixed, no
+    // localtime/mktime needed)
+    time_t wake = time(nullptr) + seconds;
+    uint32_t secondOfDay = (uint32_t)((int64_t)wake + TIMEZONE_OFFSET -
+                                      (int64_t)TimeKeeper::localDay(wake) * 86400);
+    if (!isQuietHour(secondOfDay / 3600)) {
+        return seconds;
+    }
+
+    // Sleep through to the end of the quiet period instead
+    uint32_t untilEnd = (QUIET_HOURS_END * 3600UL + 86400 - secondOfDay) % 86400;
+    LOG_INFO("Next wake falls in quiet hours, sleeping until they end");
+    return seconds + untilEnd;
+}
+
+bool WakeScheduler::isQuietHour(int hour) {
+    if (QUIET_HOURS_START < QUIET_HOURS_END) {
+        return hour >= QUIET_HOURS_START && hour < QUIET_HOURS_END;
+    }
+    // Window wraps around midnight
+    return hour >= QUIET_HOURS_START || hour < QUIET_HOURS_END;
+}
@@ -1,61 +1,79 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include "config.h"
+#include "Log.h"
 #include "GoalData.h"
+#include "AdaptiveTimeout.h"
+#include "BusyWait.h"
+#include "CircuitBreaker.h"
 #include "NetworkManager.h"
+#include "OtaUpdater.h"
 #include "DisplayManager.h"
+#include "TimeKeeper.h"
+#include "WakeProfiler.h"
+#include "WakeScheduler.h"
 
 // Sleep configuration
 #define uS_TO_S_FACTOR 1000000ULL
-#define TIME_TO_SLEEP (UPDATE_INTERVAL / 1000)
 
 void goToSleep() {
-    Serial.println("\n---------------------------------");
-    Serial.print("Going to deep sleep for ");
-    Serial.print(TIME_TO_SLEEP / 60);
-    Serial.println(" minutes...");
-    Serial.println("---------------------------------");
-    Serial.flush();
+    // Sleep interval adapts to how often the data changes
+    uint32_t sleepSeconds = WakeScheduler::planSleep();
+
+    LOG_INFO("Awake for %lu ms, going to deep sleep for %lu minutes...",
+             (unsigned long)(esp_timer_get_time() / 1000), (unsigned long)(sleepSeconds / 60));
+    Log::flush();
+
+    // Remember when we went to sleep so the clock can be restored on wake
+    TimeKeeper::prepareSleep(sleepSeconds);
 
     // Power down display
     DisplayManager::hibernate();
 
-    // Disconnect WiFi to save power
-    WiFi.disconnect(true);
-    WiFi.mode(WIFI_OFF);
+    // Disconnect WiFi to save power (usually already off by now)
+    NetworkManager::disconnect();
+
+    // Keep this wake's timings for upload on the next successful fetch
+    WakeProfiler::commit();
+
+    // A firmware update was written this wake, boot it instead of sleeping
+    if (OtaUpdater::updateReady()) {
+        LOG_INFO("Restarting into the new firmware");
+        Log::flush();
+        esp_restart();
+    }
 
     // Disable GPIO hold circuits to ensure pins don't stay active during deep sleep
     gpio_deep_sleep_hold_dis();
 
     delay(100);
 
+    // Armed last: the panel's BUSY waits above use the timer for light sleep
+    BusyWait::setSleepTimer(sleepSeconds * uS_TO_S_FACTOR);
+
     // Enter deep sleep
     esp_deep_sleep_start();
 }
 
 void setup() {
-    Serial.begin(115200);
-    delay(1000);
-
-    Serial.println("\n=================================");
-    Serial.println("Goal Tracker - E-ink Display");
-    Serial.print("Version: ");
-    Serial.print(FIRMWARE_VERSION);
-    Serial.print(" (");
-    Serial.print(BUILD_DATE);
-    Serial.print(" ");
-    Serial.print(BUILD_TIME);
-    Serial.println(")");
-    Serial.println("=================================");
-
-    // Configure deep sleep timer
-    esp_sleep_enable_timer_wakeup(TIME_TO_SLEEP * uS_TO_S_FACTOR);
-    Serial.print("Configured to sleep for: ");
-    Serial.print(TIME_TO_SLEEP);
-    Serial.println(" seconds");
-
-    // Initialize display
-    DisplayManager::init();
+    WakeProfiler::begin();
+    Log::begin();
+
+    // An unconfirmed firmware update may have to be rolled back
+    OtaUpdater::begin();
+
+    LOG_INFO("Goal Tracker - E-ink Display, version %s (%s %s)",
+             FIRMWARE_VERSION, BUILD_DATE, BUILD_TIME);
+
+    // Restore wall-clock time kept across deep sleep
+    TimeKeeper::restore();
+
+    // Network phases from here on share the wake's time budget
+    CircuitBreaker::beginWake();
+    WakeScheduler::beginWake();
+
+    // Each wake shows the next goal page (always page 0 with a single goal)
+    uint8_t page = DataStorage::nextPage();
 
     // Create data structure
     GoalData data;
@@ -64,48 +82,112 @@ void setup() {
 
     // Load cached data from RTC memory (survives deep sleep)
     if (DataStorage::hasData()) {
-        Serial.println("Loading cached data from previous update...");
-        DataStorage::load(data);
+        LOG_DEBUG("Loading cached data from previous update...");
+        DataStorage::load(data, page);
     }
 
-    if (!NetworkManager::connectWiFi()) {
-        Serial.println("WiFi connection failed!");
+    // If the panel will be redrawn whatever the fetch returns, power it up in
+    // the background now so the settle time overlaps the network wait
+    if (!DataStorage::hasData() || DisplayManager::needsRedraw(data)) {
+        DisplayManager::beginInit();
     }
 
-    // Fetch goal data
-    GoalData newData;
-    if (NetworkManager::fetchGoalData(newData)) {
-        // Success - update with fresh data (timestamp already set by fetchGoalData)
-        newData.lastUpdateSuccess = true;
-        newData.targetDate = NetworkManager::getTargetDate(newData.daysToGoal);
+    // With several goals or local updates most wakes only turn the page or
+    // count the days down, the radio stays off
+    bool fetchDue = !DataStorage::hasData() || WakeScheduler::fetchDue();
+    if (fetchDue) {
+        bool wifiConnected = false;
+        if (CircuitBreaker::allow(BREAKER_WIFI)) {
+            wifiConnected = NetworkManager::connectWiFi();
+        }
+        if (!wifiConnected) {
+            LOG_WARN("WiFi connection failed!");
+        }
+
+        // NTP (only when due) runs in the background during the HTTP fetch
+        bool ntpStarted = wifiConnected && TimeKeeper::needsSync() && CircuitBreaker::allow(BREAKER_NTP);
+        if (ntpStarted) {
+            TimeKeeper::beginSync();
+        }
 
-        // Save to RTC memory for next wake cycle
-        DataStorage::save(newData);
+        // Fetch all goals with one request
+        GoalData newData[GOAL_COUNT];
+        uint8_t count = 0;
+        bool fetched = false;
+        if (CircuitBreaker::allow(BREAKER_HTTP)) {
+            fetched = NetworkManager::fetchGoals(newData, GOAL_COUNT, count);
+        }
+        if (ntpStarted) {
+            bool synced = TimeKeeper::finishSync(CircuitBreaker::limitTimeout(AdaptiveTimeout::get(TIMEOUT_NTP)));
+            CircuitBreaker::recordNtp(synced);
+        }
+        CircuitBreaker::recordWake(fetched);
+
+        if (fetched) {
+            // A new firmware has proven it can fetch, keep it
+            OtaUpdater::confirm();
+            // Update offered with the data, pulled while the radio is on
+            if (OtaUpdater::hasOffer()) {
+                OtaUpdater::apply();
+            }
+        }
 
-        // Use the new data
-        data = newData;
+        // Radio off as soon as the data is in, before the multi-second refresh
+        NetworkManager::disconnect();
 
-        Serial.println("Data fetched and cached successfully!");
-    } else {
-        // Failed - use cached data if available
-        Serial.println("Error: Could not fetch data");
+        if (fetched) {
+            // Success - update with fresh data (timestamps already set by fetchGoals)
+            for (uint8_t i = 0; i < count; i++) {
+                newData[i].lastUpdateSuccess = true;
 
-        if (DataStorage::hasData()) {
-            Serial.println("Using cached data from previous update");
-            data.lastUpdateSuccess = false;  // Mark as offline
+                // Save to RTC memory for next wake cycle
+                DataStorage::save(newData[i], i);
+            }
+            DataStorage::setGoalCount(count);
+
+            // Change tracking for the adaptive schedule follows the first goal
+            WakeScheduler::recordFetch(newData[0]);
+
+            // Use the stored copy: it carries the trend history and the target
+            // date derived from the fetch time
+            DataStorage::load(data, DataStorage::currentPage());
+
+            LOG_INFO("Data fetched and cached successfully!");
         } else {
-            Serial.println("No cached data available!");
-            DisplayManager::showError("No data available");
-            delay(3000);
-            goToSleep();
-            return;
+            // Failed - use cached data if available
+            LOG_WARN("Could not fetch data");
+
+            if (DataStorage::hasData()) {
+                LOG_INFO("Using cached data from previous update");
+                // Only mark as offline once the outage persists, a single
+                // failed wake isn't worth a display refresh
+                if (CircuitBreaker::showOffline()) {
+                    data.lastUpdateSuccess = false;
+                }
+            } else {
+                LOG_ERROR("No cached data available!");
+                DisplayManager::init();
+                DisplayManager::showError("No data available");
+                delay(3000);
+                goToSleep();
+                return;
+            }
         }
+    } else if (CircuitBreaker::showOffline()) {
+        // Pages shown between fetch attempts still show the outage
+        data.lastUpdateSuccess = false;
     }
 
-    // Update display with current or cached data
+    // Update display with current or cached data, but only power up the
+    // panel if something visible changed since the last refresh
     if (data.isValid) {
-        DisplayManager::showGoalInfo(data);
-        Serial.println("Display updated!");
+        if (DisplayManager::needsRedraw(data)) {
+            DisplayManager::init();
+            DisplayManager::showGoalInfo(data);
+            LOG_DEBUG("Display updated!");
+        } else {
+            LOG_DEBUG("Display content unchanged, skipping refresh");
+        }
     }
 
     // Go to deep sleep
@@ -0,0 +1,426 @@
+#include "Fixtures.h"
+#include <ArduinoJson.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include "AdaptiveTimeout.h"
+#include "BusyWait.h"
+#include "CircuitBreaker.h"
+#include "Crc32.h"
+#include "FrameCanvas.h"
+#include "GoalRenderer.h"
+#include "Log.h"
+#include "NetworkManager.h"
+#include "OtaUpdater.h"
+#include "TimeKeeper.h"
+#include "WakeScheduler.h"
+
+std::string makePayload(int holdings) {
+    std::string json =
+        "{\"goal_tracking\":{\"current_progress_percent\":22.2,\"target_amount\":1000000,"
+        "\"current_amount\":222000},\"projection\":{\"days_to_target\":3750,"
+        "\"monthly_contribution\":1500,\"expected_return\":0.07},\"holdings\":[";
+    for (int i = 0; i < holdings; i++) {
+        char entry[160];
+        snprintf(entry, sizeof(entry),
+                 "%s{\"symbol\":\"SYM%03d\",\"name\":\"Holding number %d\",\"shares\":%d.5,"
+                 "\"price\":%d.25,\"weight\":0.0%d}",
+                 i > 0 ? "," : "", i, i, 10 + i, 100 + i, i % 10);
+        json += entry;
+    }
+    json += "],\"metadata\":{\"data_timestamp\":\"2025-10-28T11:51:53.666Z\",\"source\":\"bench\"}}";
+    return json;
+}
+
+std::string makeBatchPayload(int goals) {
+    std::string json = "{\"goals\":[";
+    for (int i = 0; i < goals; i++) {
+        char entry[320];
+        snprintf(entry, sizeof(entry),
+                 "%s{\"name\":\"GOAL %d\",\"goal_tracking\":{\"current_progress_percent\":%d.5,"
+                 "\"target_amount\":1000000},\"projection\":{\"days_to_target\":%d},"
+                 "\"metadata\":{\"data_timestamp\":\"2025-10-28T11:51:53.666Z\"}}",
+                 i > 0 ? "," : "", i + 1, 10 + i * 20, 3750 - i * 900);
+        json += entry;
+    }
+    json += "]}";
+    return json;
+}
+
+std::string toMsgPack(const std::string& json) {
+    JsonDocument doc;
+    deserializeJson(doc, json);
+    std::string packed;
+    serializeMsgPack(doc, packed);
+    return packed;
+}
+
+void setUpNetwork() {
+    FakeWiFi::reset();
+    FakeWiFi::addAccessPoint({WIFI_SSID, {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56}, 6, -58});
+    FakeWiFi::addAccessPoint({"Neighbour", {0x24, 0x0A, 0xC4, 0x65, 0x43, 0x21}, 11, -80});
+    FakeHttp::reset();
+}
+
+time_t localEpoch(const char* isoTime) {
+    return TimeKeeper::parseIsoTime(isoTime) - TIMEZONE_OFFSET;
+}
+
+GoalData makeSample() {
+    GoalData sample;
+    sample.daysToGoal = 3750;
+    sample.progressPercent = 22.2f;
+    sample.dataTime = localEpoch("2025-10-28T11:51:00Z");
+    sample.targetTime = localEpoch("2037-03-02T12:00:00Z");
+    sample.isValid = true;
+    sample.lastUpdateSuccess = true;
+    // Two weeks of slowly rising progress, one day missing
+    for (uint8_t i = 0; i < 14; i++) {
+        uint16_t day = 20375 + i + (i >= 9 ? 1 : 0);
+        sample.trend[sample.trendCount++] = {day, (uint16_t)(2140 + i * 6 + (i % 3) * 4)};
+    }
+    return sample;
+}
+
+bool fetchAndStore(GoalData& data) {
+    CircuitBreaker::beginWake();
+    NetworkManager::connectWiFi();
+    bool fetched = NetworkManager::fetchGoalData(data);
+    NetworkManager::disconnect();
+    if (fetched) {
+        data.lastUpdateSuccess = true;
+        DataStorage::save(data);
+        DataStorage::setGoalCount(1);
+    }
+    return fetched;
+}
+
+bool sameGoal(const GoalData& a, const GoalData& b) {
+    return a.daysToGoal == b.daysToGoal && a.progressPercent == b.progressPercent &&
+           a.dataTime == b.dataTime && a.trendCount == b.trendCount &&
+           a.lastUpdateSuccess == b.lastUpdateSuccess;
+}
+
+const OutageDay OUTAGE_WEEK[] = {
+    {"normal", true, 200, 80},
+    {"AP down", false, 200, 80},
+    {"AP down", false, 200, 80},
+    {"AP down", false, 200, 80},
+    {"API hangs", true, 200, 60000},  // beyond the HTTP timeout
+    {"API 503", true, 503, 80},
+    {"normal", true, 200, 80},
+};
+const size_t OUTAGE_WEEK_DAYS = sizeof(OUTAGE_WEEK) / sizeof(OUTAGE_WEEK[0]);
+
+SimulatedWake simulateWake() {
+    SimulatedWake wake = {};
+    unsigned long start = millis();
+    CircuitBreaker::beginWake();
+    WakeScheduler::beginWake();
+    uint8_t page = DataStorage::nextPage();
+    if (DataStorage::hasData()) {
+        DataStorage::load(wake.shown, page);
+    }
+    wake.usedRadio = !DataStorage::hasData() || WakeScheduler::fetchDue();
+    if (wake.usedRadio) {
+        if (CircuitBreaker::allow(BREAKER_WIFI)) {
+            NetworkManager::connectWiFi();
+        }
+
+        GoalData goals[GOAL_COUNT];
+        uint8_t count = 0;
+        if (CircuitBreaker::allow(BREAKER_HTTP)) {
+            wake.fetched = NetworkManager::fetchGoals(goals, GOAL_COUNT, count);
+        }
+        CircuitBreaker::recordWake(wake.fetched);
+        NetworkManager::disconnect();
+
+        if (wake.fetched) {
+            for (uint8_t i = 0; i < count; i++) {
+                goals[i].lastUpdateSuccess = true;
+                DataStorage::save(goals[i], i);
+            }
+            DataStorage::setGoalCount(count);
+            WakeScheduler::recordFetch(goals[0]);
+            DataStorage::load(wake.shown, DataStorage::currentPage());
+        }
+    }
+    if (!wake.fetched && CircuitBreaker::showOffline()) {
+        wake.shown.lastUpdateSuccess = false;
+    }
+    wake.awakeMs = millis() - start;
+    return wake;
+}
+
+uint32_t simulateSleep() {
+    uint32_t sleepSeconds = WakeScheduler::planSleep();
+    TimeKeeper::prepareSleep(sleepSeconds);
+    delay(sleepSeconds * 1000UL);
+    return sleepSeconds;
+}
+
+void setUpOutageDay(const OutageDay& day, const std::string& payload) {
+    FakeWiFi::setReachable(day.apReachable);
+    FakeHttp::setResponse({day.httpCode, payload, {}, day.latencyMs});
+}
+
+template <typename Body>
+static void measure(std::vector<HeapSection>& sections, const char* name, bool allocationFree, Body body) {
+    HostHeap::resetPeak();
+    uint32_t baseline = HostHeap::bytesInUse();
+    uint32_t allocationsBefore = HostHeap::allocations();
+    body();
+    uint32_t allocations = HostHeap::allocations() - allocationsBefore;
+    sections.push_back({name, allocationFree, allocations, HostHeap::peakBytes() - baseline});
+}
+
+std::vector<HeapSection> measureWakeHeap() {
+    setUpNetwork();
+    FakeHttp::setResponse({200, makePayload(10), {}, 80});
+    FrameCanvas canvas(DISPLAY_LAYOUT.width, DISPLAY_LAYOUT.height);
+    GoalData data;
+    GoalData fetched[GOAL_COUNT];
+    uint8_t count = 0;
+    std::vector<HeapSection> sections;
+    sections.reserve(8);
+
+    measure(sections, "log + OTA trial check", true, [] {
+        Log::begin();
+        OtaUpdater::begin();
+    });
+    measure(sections, "restore clock", true, [] {
+        TimeKeeper::restore();
+    });
+    measure(sections, "load cached data", true, [&] {
+        DataStorage::load(data, DataStorage::nextPage());
+    });
+    measure(sections, "connect + fetch", false, [&] {
+        CircuitBreaker::beginWake();
+        NetworkManager::connectWiFi();
+        NetworkManager::fetchGoals(fetched, GOAL_COUNT, count);
+        NetworkManager::disconnect();
+    });
+    measure(sections, "store + reload", true, [&] {
+        for (uint8_t i = 0; i < count; i++) {
+            fetched[i].lastUpdateSuccess = true;
+            DataStorage::save(fetched[i], i);
+        }
+        DataStorage::setGoalCount(count);
+        WakeScheduler::recordFetch(fetched[0]);
+        DataStorage::load(data, DataStorage::currentPage());
+    });
+    measure(sections, "signature + render", true, [&] {
+        GoalRenderer::makeSignature<DISPLAY_LAYOUT>(data);
+        GoalRenderer::draw<DISPLAY_LAYOUT>(canvas, data);
+    });
+    measure(sections, "plan sleep", true, [] {
+        TimeKeeper::prepareSleep(WakeScheduler::planSleep());
+    });
+    return sections;
+}
+
+std::vector<RenderStep> makeRenderSteps() {
+    std::vector<RenderStep> steps;
+    GoalData data = makeSample();
+    steps.push_back({"initial", data});
+    steps.push_back({"unchanged", data});
+    data.dataTime = localEpoch("2025-10-28T12:51:00Z");
+    steps.push_back({"footer", data});
+    data.daysToGoal = 3749;
+    data.targetTime = localEpoch("2037-03-01T12:00:00Z");
+    steps.push_back({"days_and_date", data});
+    data.progressPercent = 22.3f;
+    steps.push_back({"progress_text", data});
+    data.progressPercent = 23.9f;
+    steps.push_back({"progress_bar", data});
+    data.trend[data.trendCount++] = {20390, 2390};
+    steps.push_back({"trend", data});
+    data.lastUpdateSuccess = false;
+    steps.push_back({"offline", data});
+    data.lastUpdateSuccess = true;
+    data.dataTime = localEpoch("2025-10-28T14:51:00Z");
+    steps.push_back({"back_online", data});
+    data.daysToGoal = 12;
+    data.progressPercent = 99.6f;
+    data.targetTime = localEpoch("2026-11-09T12:00:00Z");
+    steps.push_back({"near_goal", data});
+    return steps;
+}
+
+bool contains(const GoalRenderer::Rect& window, const GoalRenderer::Rect& r) {
+    return r.w == 0 || (r.x >= window.x && r.y >= window.y && r.x + r.w <= window.x + window.w &&
+                        r.y + r.h <= window.y + window.h);
+}
+
+std::string makeImage(size_t size, uint32_t seed) {
+    std::string image(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        image[i] = (char)(seed >> 16);
+    }
+    image[0] = (char)0xE9;
+    return image;
+}
+
+// Writes a patch op by op (format in DeltaPatch.h) together with the image
+// it must produce, for the checks; tools/make_delta.py finds the ops itself
+class DeltaBuilder {
+public:
+    explicit DeltaBuilder(const std::string& old) : old(old) {}
+
+    // edits: offsets within the copy and the bytes replacing the old ones
+    void copy(uint32_t source, uint32_t length,
+              const std::vector<std::pair<uint32_t, std::string>>& edits = {}) {
+        ops += DELTA_OP_COPY;
+        put32(source);
+        put32(length);
+        put16((uint16_t)edits.size());
+        std::string bytes = old.substr(source, length);
+        uint32_t end = 0;
+        for (const auto& edit : edits) {
+            put16((uint16_t)(edit.first - end));
+            ops += (char)edit.second.size();
+            ops += edit.second;
+            bytes.replace(edit.first, edit.second.size(), edit.second);
+            end = edit.first + edit.second.size();
+        }
+        image += bytes;
+    }
+
+    void insert(const std::string& bytes) {
+        ops += DELTA_OP_INSERT;
+        put32((uint32_t)bytes.size());
+        ops += bytes;
+        image += bytes;
+    }
+
+    std::string patch() const {
+        std::string header = DELTA_MAGIC;
+        for (uint32_t value : {(uint32_t)old.size(), crc(old), (uint32_t)image.size(), crc(image)}) {
+            for (int i = 0; i < 4; i++) {
+                header += (char)(value >> (8 * i));
+            }
+        }
+        return header + ops + DELTA_OP_END;
+    }
+
+    const std::string& result() const { return image; }
+
+private:
+    static uint32_t crc(const std::string& bytes) {
+        return crc32(0, (const uint8_t*)bytes.data(), bytes.size());
+    }
+    void put32(uint32_t value) {
+        put16((uint16_t)value);
+        put16((uint16_t)(value >> 16));
+    }
+    void put16(uint16_t value) {
+        ops += (char)value;
+        ops += (char)(value >> 8);
+    }
+
+    const std::string& old;
+    std::string ops;
+    std::string image;
+};
+
+static bool readOldImage(void* context, uint32_t offset, uint8_t* buffer, size_t size) {
+    const std::string& old = *((DeltaImages*)context)->old;
+    if (offset > old.size() || size > old.size() - offset) {
+        return false;
+    }
+    memcpy(buffer, old.data() + offset, size);
+    return true;
+}
+
+static bool writeNewImage(void* context, const uint8_t* bytes, size_t size) {
+    ((DeltaImages*)context)->result.append((const char*)bytes, size);
+    return true;
+}
+
+DeltaPatch::Result applyDelta(const std::string& old, const std::string& patch, size_t chunk,
+                              DeltaImages& images, const char** error) {
+    images.old = &old;
+    images.result.clear();
+    DeltaPatch delta(readOldImage, writeNewImage, &images);
+    DeltaPatch::Result result = DeltaPatch::PATCH_MORE;
+    for (size_t offset = 0; offset < patch.size() && result == DeltaPatch::PATCH_MORE; offset += chunk) {
+        result = delta.feed((const uint8_t*)patch.data() + offset, min(chunk, patch.size() - offset));
+    }
+    if (error) {
+        *error = delta.error();
+    }
+    return result;
+}
+
+DeltaCase makeDeltaCase() {
+    DeltaCase test;
+    test.old = makeImage(48 * 1024, 1);
+    DeltaBuilder builder(test.old);
+    builder.copy(0, 1000);
+    builder.insert(makeImage(300, 2));
+    std::vector<std::pair<uint32_t, std::string>> relocations;
+    for (uint32_t at = 16; at + 4 <= 29000; at += 64) {
+        relocations.push_back({at, std::string("\x2c\x01\x00\x42", 4)});
+    }
+    builder.copy(1000, 29000, relocations);
+    builder.copy(30200, (uint32_t)test.old.size() - 30200);
+    builder.insert(makeImage(2048, 3));
+    test.image = builder.result();
+    test.patch = builder.patch();
+    return test;
+}
+
+// GxEPD2's _waitWhileBusy with a busy callback; returns the time waited (ms)
+static unsigned long waitWhileBusy(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (digitalRead(EPD_BUSY) == HIGH) {
+        BusyWait::callback(nullptr);
+        if (millis() - start > timeoutMs) {
+            break;
+        }
+    }
+    return millis() - start;
+}
+
+unsigned long busyRefresh(bool lightSleep, unsigned long refreshMs) {
+    FakeGpio::setLevel(EPD_BUSY, HIGH);
+    if (refreshMs > 0) {
+        FakeGpio::scheduleLevel(EPD_BUSY, LOW, refreshMs);
+    }
+    BusyWait::begin(lightSleep);
+    unsigned long waitedMs = waitWhileBusy(BUSY_TIMEOUT_MS);
+    BusyWait::end("fixture");
+    FakeGpio::setLevel(EPD_BUSY, LOW);
+    return waitedMs;
+}
+
+const TimeoutStep TIMEOUT_STEPS[] = {
+    {"learning", 300, TIMEOUT_MIN_SAMPLES},
+    {"steady", 300, 40},
+    {"hangs", 60000, 8},
+    {"recovered", 300, 8},
+    {"10x slower", 3000, 20},
+};
+const size_t TIMEOUT_STEPS_COUNT = sizeof(TIMEOUT_STEPS) / sizeof(TIMEOUT_STEPS[0]);
+
+bool timeoutWake(const std::string& payload, unsigned long latencyMs, uint32_t& seed,
+                 unsigned long& radioMs) {
+    auto jittered = [&seed](unsigned long ms) {
+        seed = seed * 1103515245 + 12345;
+        return ms - ms / 4 + (seed >> 16) % (ms / 2 + 1);
+    };
+    FakeWiFi::setTimings(jittered(150), jittered(400), 120);
+    FakeHttp::setResponse({200, payload, {}, jittered(latencyMs)});
+    unsigned int timeoutsBefore = FakeHttp::timeoutCount();
+
+    unsigned long start = millis();
+    CircuitBreaker::beginWake();
+    GoalData data;
+    if (NetworkManager::connectWiFi()) {
+        NetworkManager::fetchGoalData(data);
+    }
+    NetworkManager::disconnect();
+    radioMs += millis() - start;
+    delay(3600UL * 1000);
+    return FakeHttp::timeoutCount() != timeoutsBefore;
+}
@@ -0,0 +1,142 @@
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "DeltaPatch.h"
+#include "GoalData.h"
+#include "GoalRenderer.h"
+
+// Payloads, goals and wakes shared by the host benchmark (bench_main.cpp)
+// and the Unity suites in test/ (native build only)
+
+// Recorded response of the portfolio summary endpoint, with `holdings`
+// extra entries to model the size of a real portfolio
+std::string makePayload(int holdings);
+
+// Batched response with `goals` goals of the same shape
+std::string makeBatchPayload(int goals);
+
+// The same document as MessagePack, as a server honouring Accept sends it
+std::string toMsgPack(const std::string& json);
+
+// Our access point and a neighbour in range, and a fresh API server
+void setUpNetwork();
+
+// Epoch whose local time reads as `isoTime`, so results don't depend on
+// TIMEZONE_OFFSET
+time_t localEpoch(const char* isoTime);
+
+// A goal with two weeks of trend history
+GoalData makeSample();
+
+// Fetch part of a wake as main.cpp does it: fresh goals are stored as online
+bool fetchAndStore(GoalData& data);
+
+// Same values on screen
+bool sameGoal(const GoalData& a, const GoalData& b);
+
+// What one simulated wake did and the goal it left on screen
+struct SimulatedWake {
+    bool usedRadio;  // not just a page turn
+    bool fetched;
+    unsigned long awakeMs;
+    GoalData shown;
+};
+
+// setup() of main.cpp for one wake, up to the display update
+SimulatedWake simulateWake();
+
+// Sleeps as planned at the end of a simulated wake; returns the seconds
+uint32_t simulateSleep();
+
+// One day of the outage simulation
+struct OutageDay {
+    const char* condition;
+    bool apReachable;
+    int httpCode;
+    unsigned long latencyMs;
+};
+
+// A week with the access point and then the API down for days
+extern const OutageDay OUTAGE_WEEK[];
+extern const size_t OUTAGE_WEEK_DAYS;
+
+// Access point and API server as they are on `day`, answering with `payload`
+void setUpOutageDay(const OutageDay& day, const std::string& payload);
+
+// Allocations and heap high-water of one section of a wake
+struct HeapSection {
+    const char* name;
+    bool allocationFree;  // must stay off the heap
+    uint32_t allocations;
+    uint32_t peakBytes;
+};
+
+// Runs one wake section by section. Only the network stack (HTTPClient,
+// ArduinoJson) may allocate; the boot checks, the clock, the goal data, its
+// formatting, RTC storage, rendering and the sleep plan must not.
+std::vector<HeapSection> measureWakeHeap();
+
+// One frame of the render sequence
+struct RenderStep {
+    const char* name;
+    GoalData data;
+};
+
+// A sequence of frames as successive wakes would draw them
+std::vector<RenderStep> makeRenderSteps();
+
+// Whether `r` lies inside `window`; an empty `r` always does
+bool contains(const GoalRenderer::Rect& window, const GoalRenderer::Rect& r);
+
+// Pseudo-random stand-in for a firmware image (app images start with 0xE9)
+std::string makeImage(size_t size, uint32_t seed);
+
+// Base image in memory and the new image being written
+struct DeltaImages {
+    const std::string* old;
+    std::string result;
+};
+
+// Feeds the patch to DeltaPatch in chunks of `chunk` bytes; result holds
+// the new image
+DeltaPatch::Result applyDelta(const std::string& old, const std::string& patch, size_t chunk,
+                              DeltaImages& images, const char** error = nullptr);
+
+// Old image, a new one with code inserted, moved (a few bytes of each
+// relocated word differ), deleted and appended, and the patch between them
+struct DeltaCase {
+    std::string old;
+    std::string image;
+    std::string patch;
+};
+
+DeltaCase makeDeltaCase();
+
+// GxEPD2's busy timeout, which a panel stuck in BUSY runs into
+#define BUSY_TIMEOUT_MS 10000
+
+// One refresh whose BUSY line is high for `refreshMs` (or never drops with
+// 0), waited for as GxEPD2 does; returns the time waited (ms).
+// BusyWait::stats() and chargeUaMs() hold the wait afterwards.
+unsigned long busyRefresh(bool lightSleep, unsigned long refreshMs);
+
+// One phase of the API in the adaptive timeout run, `wakes` hourly wakes long
+struct TimeoutStep {
+    const char* name;
+    unsigned long latencyMs;
+    unsigned wakes;
+};
+
+// Learning, steady, hanging, recovered and 10x slower
+extern const TimeoutStep TIMEOUT_STEPS[];
+extern const size_t TIMEOUT_STEPS_COUNT;
+
+// One hourly wake's connect and fetch with the association and the API's
+// answer jittered by +-25%; returns whether the request timed out
+bool timeoutWake(const std::string& payload, unsigned long latencyMs, uint32_t& seed,
+                 unsigned long& radioMs);
+
+#endif // FIXTURES_H
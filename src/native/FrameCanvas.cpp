@@ -0,0 +1,144 @@
+#include "FrameCanvas.h"
+#include <chrono>
+
+static unsigned long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameCanvas::FrameCanvas(uint16_t width, uint16_t height)
+    : GFXcanvas1(width, height), depth(0), current(CALL_OTHER), startNs(0) {
+    resetStats();
+}
+
+void FrameCanvas::resetStats() {
+    memset(&counters, 0, sizeof(counters));
+}
+
+const char* FrameCanvas::callName(Call call) {
+    switch (call) {
+        case CALL_FILL: return "fill";
+        case CALL_LINE: return "line";
+        case CALL_RECT: return "rect";
+        case CALL_GLYPH: return "glyph";
+        case CALL_OTHER: return "other";
+        default: return "?";
+    }
+}
+
+void FrameCanvas::begin(Call call) {
+    if (depth++ == 0) {
+        current = call;
+        startNs = nowNs();
+    }
+}
+
+void FrameCanvas::end() {
+    if (--depth == 0) {
+        counters.calls[current]++;
+        counters.us[current] += (nowNs() - startNs) / 1000.0;
+    }
+}
+
+void FrameCanvas::fillScreen(uint16_t color) {
+    begin(CALL_FILL);
+    GFXcanvas1::fillScreen(color);
+    end();
+}
+
+void FrameCanvas::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    begin(CALL_LINE);
+    GFXcanvas1::drawLine(x0, y0, x1, y1, color);
+    end();
+}
+
+void FrameCanvas::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    begin(CALL_RECT);
+    GFXcanvas1::drawRect(x, y, w, h, color);
+    end();
+}
+
+void FrameCanvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    begin(CALL_FILL);
+    GFXcanvas1::fillRect(x, y, w, h, color);
+    end();
+}
+
+void FrameCanvas::startWrite() {
+    begin(CALL_OTHER);
+}
+
+void FrameCanvas::endWrite() {
+    end();
+}
+
+size_t FrameCanvas::write(uint8_t c) {
+    if (c == '\n' || c == '\r') {
+        return GFXcanvas1::write(c);
+    }
+    begin(CALL_GLYPH);
+    size_t n = GFXcanvas1::write(c);
+    end();
+    return n;
+}
+
+void FrameCanvas::exportBits(uint8_t* out) const {
+    // Canvas bits are 1 = white (GxEPD_WHITE), PBM bits are 1 = black
+    size_t rowBytes = (width() + 7) / 8;
+    memset(out, 0, frameBytes());
+    for (int16_t y = 0; y < height(); y++) {
+        for (int16_t x = 0; x < width(); x++) {
+            if (!getPixel(x, y)) {
+                out[y * rowBytes + x / 8] |= 0x80 >> (x & 7);
+            }
+        }
+    }
+}
+
+bool FrameCanvas::writePbm(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    uint8_t* bits = (uint8_t*)malloc(frameBytes());
+    exportBits(bits);
+    fprintf(file, "P4\n%d %d\n", width(), height());
+    bool ok = fwrite(bits, 1, frameBytes(), file) == frameBytes();
+    free(bits);
+    return fclose(file) == 0 && ok;
+}
+
+bool FrameCanvas::readPbm(const char* path, uint8_t* out) const {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    int w = 0, h = 0;
+    // Header written by writePbm: magic, size, then one whitespace byte
+    bool ok = fscanf(file, "P4 %d %d", &w, &h) == 2 && fgetc(file) != EOF &&
+              w == width() && h == height() &&
+              fread(out, 1, frameBytes(), file) == frameBytes();
+    fclose(file);
+    return ok;
+}
+
+GoalRenderer::Rect FrameCanvas::diffBounds(const uint8_t* a, const uint8_t* b) const {
+    size_t rowBytes = (width() + 7) / 8;
+    int16_t left = width(), top = height(), right = -1, bottom = -1;
+    for (int16_t y = 0; y < height(); y++) {
+        for (int16_t x = 0; x < width(); x++) {
+            size_t i = y * rowBytes + x / 8;
+            uint8_t mask = 0x80 >> (x & 7);
+            if ((a[i] ^ b[i]) & mask) {
+                left = min(left, x);
+                right = max(right, x);
+                top = min(top, y);
+                bottom = max(bottom, y);
+            }
+        }
+    }
+    if (right < 0) {
+        return {0, 0, 0, 0};
+    }
+    return {left, top, (int16_t)(right - left + 1), (int16_t)(bottom - top + 1)};
+}
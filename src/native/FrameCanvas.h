@@ -0,0 +1,65 @@
+#ifndef FRAME_CANVAS_H
+#define FRAME_CANVAS_H
+
+#include <Adafruit_GFX.h>
+#include "GoalRenderer.h"
+
+// Offscreen 1-bpp stand-in for the e-ink panel (native build only).
+// GoalRenderer draws into it through the same Adafruit_GFX interface as the
+// GxEPD2 display; it counts draw calls and glyphs, times them, and can dump
+// the frame as a PBM image or compare it against one.
+class FrameCanvas : public GFXcanvas1 {
+public:
+    enum Call : uint8_t {
+        CALL_FILL,
+        CALL_LINE,
+        CALL_RECT,
+        CALL_GLYPH,
+        CALL_OTHER,  // circles, triangles etc. (anything bracketed by startWrite)
+        CALL_COUNT
+    };
+
+    struct Stats {
+        uint32_t calls[CALL_COUNT];
+        double us[CALL_COUNT];
+    };
+
+    FrameCanvas(uint16_t width, uint16_t height);
+
+    void resetStats();
+    const Stats& stats() const { return counters; }
+    static const char* callName(Call call);
+
+    // Top-level drawing entry points; nested calls (a rect drawing its
+    // lines) are not counted again
+    void fillScreen(uint16_t color) override;
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) override;
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void startWrite() override;
+    void endWrite() override;
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    // Black pixels as set bits, row-padded to whole bytes (PBM P4 layout)
+    void exportBits(uint8_t* out) const;
+    size_t frameBytes() const { return (size_t)((width() + 7) / 8) * height(); }
+
+    bool writePbm(const char* path) const;
+    bool readPbm(const char* path, uint8_t* out) const;
+
+    // Bounding box of the pixels that differ between two exported frames
+    // (w == 0 when identical)
+    GoalRenderer::Rect diffBounds(const uint8_t* a, const uint8_t* b) const;
+
+private:
+    void begin(Call call);
+    void end();
+
+    Stats counters;
+    int depth;
+    Call current;
+    unsigned long long startNs;
+};
+
+#endif // FRAME_CANVAS_H
@@ -0,0 +1,32 @@
+#include "TlsClient.h"
+
+// Host build: the fake HTTPClient answers HTTPS requests like plain ones
+// and never uses the transport, so there is no TLS here (the device version
+// in src/TlsClient.cpp needs mbedTLS). Connecting always fails.
+
+RTC_DATA_ATTR uint8_t TlsClient::rtc_session[TLS_SESSION_SIZE] = {0};
+RTC_DATA_ATTR uint16_t TlsClient::rtc_sessionLength = 0;
+RTC_DATA_ATTR uint32_t TlsClient::rtc_sessionHost = 0;
+RTC_DATA_ATTR uint16_t TlsClient::rtc_fullHandshakes = 0;
+RTC_DATA_ATTR uint16_t TlsClient::rtc_resumedHandshakes = 0;
+
+TlsClient::~TlsClient() {}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) { return 0; }
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout) { return 0; }
+int TlsClient::connect(const char* host, uint16_t port) { return 0; }
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeout) { return 0; }
+size_t TlsClient::write(uint8_t data) { return 0; }
+size_t TlsClient::write(const uint8_t* buf, size_t size) { return 0; }
+int TlsClient::available() { return 0; }
+int TlsClient::read() { return -1; }
+int TlsClient::read(uint8_t* buf, size_t size) { return -1; }
+int TlsClient::peek() { return -1; }
+void TlsClient::flush() {}
+void TlsClient::stop() {}
+uint8_t TlsClient::connected() { return 0; }
+
+void TlsClient::clearSession() {
+    rtc_sessionLength = 0;
+    rtc_sessionHost = 0;
+}
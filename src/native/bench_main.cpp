@@ -0,0 +1,450 @@
+// Host benchmark for the wake-cycle data path and rendering (native build only).
+//
+//   pio run -e native -t exec
+//   .pio/build/native/program --frames <dir> --golden <dir>
+//
+// Runs the real NetworkManager / DataStorage / TimeKeeper code against the
+// fakes in lib/NativeHal and reports CPU time and heap use per operation.
+// Network latency is simulated on a virtual clock and not part of the timings.
+// Behaviour checks with a pass/fail result live in the Unity suites in test/
+// (pio test -e native), which build src/ without this entry point.
+//
+// The render section draws the goal screen with GoalRenderer into an
+// offscreen FrameCanvas and reports its cost; test_render checks the
+// partial-refresh windows. --frames writes each frame as PBM; --golden
+// compares them with the PBMs in <dir> (missing ones are recorded). Exits 1
+// if a frame can't be written or differs.
+//
+// The fetch rows compare the JSON and MessagePack answers of the same
+// document (bytes on the air, parse time, heap); test_network checks that
+// both give the same goal and covers the conditional GET.
+//
+// The DeltaPatch row times the OTA patcher on a hand-built patch; test_ota
+// checks the patcher and runs updates through OtaUpdater. With
+//   .pio/build/native/program --delta <old.bin> <patch> <new.bin>
+// it applies a patch from tools/make_delta.py instead and compares the
+// result with <new.bin>.
+//
+// The wake heap report runs one wake section by section; test_heap fails
+// if anything but the network stack allocates.
+//
+// The adaptive timeout rows run hourly wakes against an API with jittered
+// latency that then hangs, recovers and slows down, and report the
+// timeouts hit and the radio time; test_timeouts replays them with checks.
+//
+// The BUSY wait rows refresh against a scripted BUSY line (FakeGpio) with
+// and without light sleep; test_busy_wait checks that the sleeping wait
+// still ends on the edge, still times out, and polls while WiFi is on.
+//
+// The outage simulation runs a week of wake cycles on the virtual clock with
+// the AP and then the API down for days, and reports wakes and radio-on time
+// per day; test_wake_cycle replays it with its checks.
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <chrono>
+#include <esp_sleep.h>
+#include <vector>
+#include "config.h"
+#include "GoalData.h"
+#include "GoalRenderer.h"
+#include "Log.h"
+#include "AdaptiveTimeout.h"
+#include "BusyWait.h"
+#include "CircuitBreaker.h"
+#include "NetworkManager.h"
+#include "TimeKeeper.h"
+#include "WakeProfiler.h"
+#include "WakeScheduler.h"
+#include "FrameCanvas.h"
+#include "Fixtures.h"
+
+static void printHeader() {
+    printf("%-32s %8s %8s %12s %12s %12s\n",
+           "benchmark", "bytes", "iters", "us/op", "allocs/op", "peak heap");
+    printf("%-32s %8s %8s %12s %12s %12s\n",
+           "--------------------------------", "--------", "--------",
+           "------------", "------------", "------------");
+}
+
+// Times `body` over `iterations` runs and reports allocations and the peak
+// heap above what was in use before the first run
+template <typename Body>
+static void runBench(const char* name, size_t payloadBytes, unsigned iterations, Body body) {
+    body();  // warm-up (first-use allocations, caches)
+
+    HostHeap::resetPeak();
+    uint32_t baseline = HostHeap::bytesInUse();
+    uint32_t allocationsBefore = HostHeap::allocations();
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned i = 0; i < iterations; i++) {
+        body();
+    }
+
+    double elapsedUs = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start).count();
+    double allocations = (double)(HostHeap::allocations() - allocationsBefore) / iterations;
+    uint32_t peak = HostHeap::peakBytes() - baseline;
+
+    printf("%-32s %8zu %8u %12.2f %12.1f %12u\n",
+           name, payloadBytes, iterations, elapsedUs / iterations, allocations, (unsigned)peak);
+}
+
+static void printRenderStats(const char* name, const FrameCanvas::Stats& stats) {
+    printf("  %-16s", name);
+    for (int call = 0; call < FrameCanvas::CALL_COUNT; call++) {
+        if (stats.calls[call] > 0) {
+            printf(" %s %u (%.1f us)", FrameCanvas::callName((FrameCanvas::Call)call),
+                   (unsigned)stats.calls[call], stats.us[call]);
+        }
+    }
+    printf("\n");
+}
+
+// Renders every step with layout L; returns the number of frames that
+// could not be written or differ from their golden PBM
+template <const DisplayLayout& L>
+static int runRender(const char* framesDir, const char* goldenDir) {
+    FrameCanvas canvas(L.width, L.height);
+    std::vector<uint8_t> frame(canvas.frameBytes());
+    std::vector<uint8_t> golden(canvas.frameBytes());
+    int failures = 0;
+
+    printf("\nrender %dx%d\n", L.width, L.height);
+    std::vector<RenderStep> steps = makeRenderSteps();
+    for (size_t i = 0; i < steps.size(); i++) {
+        const RenderStep& step = steps[i];
+        canvas.resetStats();
+        GoalRenderer::draw<L>(canvas, step.data);
+        printRenderStats(step.name, canvas.stats());
+        canvas.exportBits(frame.data());
+
+        char path[256];
+        if (framesDir) {
+            snprintf(path, sizeof(path), "%s/%dx%d_%02u_%s.pbm", framesDir, L.width, L.height,
+                     (unsigned)i, step.name);
+            if (!canvas.writePbm(path)) {
+                printf("    cannot write %s\n", path);
+                failures++;
+            }
+        }
+
+        if (goldenDir) {
+            snprintf(path, sizeof(path), "%s/%dx%d_%s.pbm", goldenDir, L.width, L.height, step.name);
+            if (!canvas.readPbm(path, golden.data())) {
+                printf("    golden %s missing, recorded\n", path);
+                if (!canvas.writePbm(path)) {
+                    failures++;
+                }
+            } else {
+                GoalRenderer::Rect d = canvas.diffBounds(golden.data(), frame.data());
+                if (d.w > 0) {
+                    printf("    GOLDEN MISMATCH in %dx%d at %d,%d\n", d.w, d.h, d.x, d.y);
+                    failures++;
+                }
+            }
+        }
+    }
+
+#ifndef GOAL_PRERENDERED
+    printf("\nprerendered bitmaps not built (see tools/prerender.py), fonts only\n");
+#endif
+
+    // Cost of a full frame, as drawn by every page of a GxEPD2 refresh
+    GoalData sample = makeSample();
+    printf("\n");
+    printHeader();
+    GoalRenderer::setPrerendered(false);
+    runBench("GoalRenderer::draw (fonts)", 0, 2000, [&canvas, &sample] {
+        GoalRenderer::draw<L>(canvas, sample);
+    });
+    GoalRenderer::setPrerendered(true);
+    runBench("GoalRenderer::draw (prerendered)", 0, 2000, [&canvas, &sample] {
+        GoalRenderer::draw<L>(canvas, sample);
+    });
+    return failures;
+}
+
+// One day of wakes with the batched API: how many of them turn on the radio
+static void runPages() {
+    setUpNetwork();
+    FakeHttp::setResponse({200, makeBatchPayload(GOAL_COUNT), {}, 80});
+
+    if (FETCH_INTERVAL > 0) {
+        printf("\npages simulation, %u goal(s), fetch every %lu s (virtual clock)\n",
+               (unsigned)GOAL_COUNT, FETCH_INTERVAL / 1000);
+    } else {
+        printf("\npages simulation, %u goal(s), fetch every %u wakes (virtual clock)\n",
+               (unsigned)GOAL_COUNT, (unsigned)(GOAL_COUNT > 1 ? FETCH_EVERY_WAKES : 1));
+    }
+    unsigned wakes = 0, radioWakes = 0;
+    unsigned long awakeMs = 0;
+    time_t dayEnd = time(nullptr) + 86400;
+    while (time(nullptr) < dayEnd) {
+        SimulatedWake wake = simulateWake();
+        awakeMs += wake.awakeMs;
+        wakes++;
+        radioWakes += wake.usedRadio ? 1 : 0;
+        simulateSleep();
+    }
+    printf("wakes %u, radio wakes %u, network time %.1f s, network time per goal page %.2f s\n",
+           wakes, radioWakes, awakeMs / 1000.0, wakes ? awakeMs / 1000.0 / wakes : 0.0);
+}
+
+static void runOutage() {
+    setUpNetwork();
+    std::string payload = makePayload(10);
+
+    printf("\noutage simulation (virtual clock)\n");
+    printf("%-4s %-10s %6s %8s %12s %12s %10s\n",
+           "day", "condition", "wakes", "fetched", "awake s", "longest s", "backoff s");
+    time_t dayEnd = time(nullptr);
+    for (size_t day = 0; day < OUTAGE_WEEK_DAYS; day++) {
+        setUpOutageDay(OUTAGE_WEEK[day], payload);
+
+        unsigned wakes = 0, fetched = 0;
+        unsigned long awakeMs = 0, longestMs = 0;
+        dayEnd += 86400;
+        while (time(nullptr) < dayEnd) {
+            SimulatedWake wake = simulateWake();
+            fetched += wake.fetched ? 1 : 0;
+            awakeMs += wake.awakeMs;
+            longestMs = max(longestMs, wake.awakeMs);
+            wakes++;
+            simulateSleep();
+        }
+        printf("%-4u %-10s %6u %8u %12.1f %12.1f %10lu\n", (unsigned)day, OUTAGE_WEEK[day].condition,
+               wakes, fetched, awakeMs / 1000.0, longestMs / 1000.0,
+               (unsigned long)CircuitBreaker::backoffSeconds(UPDATE_INTERVAL / 1000));
+    }
+}
+
+// Heap use of one wake, section by section (test_heap checks which may
+// allocate). The display's background init is the one part not covered.
+static void runWakeHeap() {
+    printf("\nwake heap report (host allocations)\n");
+    printf("%-28s %8s %12s\n", "section", "allocs", "peak heap");
+    uint32_t wakePeakBytes = 0;
+    for (const HeapSection& section : measureWakeHeap()) {
+        printf("%-28s %8u %12u%s\n", section.name, (unsigned)section.allocations,
+               (unsigned)section.peakBytes,
+               section.allocationFree && section.allocations > 0 ? "  ALLOCATES" : "");
+        wakePeakBytes = max(wakePeakBytes, section.peakBytes);
+    }
+    // DisplayManager isn't in the host build; its background init allocates
+    // a FreeRTOS task and semaphore, freed once the panel is up
+    printf("%-28s %8s %12s  not measured: xTaskCreate (%u byte stack) + xSemaphoreCreateBinary\n",
+           "display background init", "-", "-", 4096u);
+    // The bench's own buffers stay out of it, unlike ESP.getMinFreeHeap()
+    printf("wake peak heap %u bytes\n", (unsigned)wakePeakBytes);
+}
+
+// Applies a patch file from tools/make_delta.py with the firmware's patcher
+// and compares the result with the expected image (--delta)
+static std::string readFile(const char* path) {
+    std::string bytes;
+    FILE* file = fopen(path, "rb");
+    if (file) {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            bytes.append(buffer, n);
+        }
+        fclose(file);
+    }
+    return bytes;
+}
+
+static int runDeltaFiles(const char* oldPath, const char* patchPath, const char* newPath) {
+    std::string old = readFile(oldPath);
+    std::string patch = readFile(patchPath);
+    std::string expected = readFile(newPath);
+    DeltaImages images;
+    const char* error = nullptr;
+    DeltaPatch::Result result = applyDelta(old, patch, 512, images, &error);
+    if (result != DeltaPatch::PATCH_DONE) {
+        printf("%s: %s\n", patchPath, result == DeltaPatch::PATCH_ERROR ? error : "patch incomplete");
+        return 1;
+    }
+    if (images.result != expected) {
+        printf("%s: result differs from %s\n", patchPath, newPath);
+        return 1;
+    }
+    printf("%s: %zu byte image from a %zu byte patch, identical to %s\n",
+           patchPath, images.result.size(), patch.size(), newPath);
+    return 0;
+}
+
+// Learned timeouts through a hang, a recovery and a slowdown of the API
+static void runTimeouts() {
+    setUpNetwork();
+    AdaptiveTimeout::relearn();
+    std::string payload = makePayload(10);
+    uint32_t seed = 1;
+
+    printf("\nadaptive timeouts (virtual clock, hourly wakes, latency +-25%%)\n");
+    printf("%-16s %8s %6s %9s %10s %12s %12s\n", "API", "latency", "wakes", "timeouts",
+           "radio s", "assoc ms", "HTTP ms");
+    for (size_t i = 0; i < TIMEOUT_STEPS_COUNT; i++) {
+        const TimeoutStep& step = TIMEOUT_STEPS[i];
+        unsigned timeouts = 0;
+        unsigned long radioMs = 0;
+        for (unsigned wake = 0; wake < step.wakes; wake++) {
+            timeouts += timeoutWake(payload, step.latencyMs, seed, radioMs) ? 1 : 0;
+        }
+        printf("%-16s %8lu %6u %9u %10.1f %12lu %12lu\n", step.name, step.latencyMs, step.wakes,
+               timeouts, radioMs / 1000.0, AdaptiveTimeout::get(TIMEOUT_ASSOCIATE),
+               AdaptiveTimeout::get(TIMEOUT_HTTP));
+    }
+    setUpNetwork();
+}
+
+// One row of the BUSY wait table
+static void busyRow(const char* name, bool lightSleep, unsigned long refreshMs) {
+    unsigned long waitedMs = busyRefresh(lightSleep, refreshMs);
+    const BusyStats& stats = BusyWait::stats();
+    printf("%-22s %6s %10lu %10lu %8u %14.1f\n", name, lightSleep ? "sleep" : "poll", waitedMs,
+           (unsigned long)stats.sleepMs, (unsigned)stats.sleeps, BusyWait::chargeUaMs() / 1e6);
+}
+
+// BUSY waits of a full and a partial refresh, polled and in light sleep
+static void runBusyWait() {
+    WiFi.mode(WIFI_OFF);
+    printf("\nBUSY wait (virtual clock, ESP32-C3 charge estimate)\n");
+    printf("%-22s %6s %10s %10s %8s %14s\n", "wait", "mode", "waited ms", "asleep ms", "sleeps", "charge mAs");
+    busyRow("full refresh", false, 3200);
+    busyRow("full refresh", true, 3200);
+    busyRow("partial refresh", false, 700);
+    busyRow("partial refresh", true, 700);
+    busyRow("stuck BUSY", true, 0);
+    WiFi.mode(WIFI_STA);
+    busyRow("partial, WiFi on", true, 700);
+    WiFi.mode(WIFI_OFF);
+}
+
+int main(int argc, char** argv) {
+    if (argc == 5 && strcmp(argv[1], "--delta") == 0) {
+        return runDeltaFiles(argv[2], argv[3], argv[4]);
+    }
+
+    const char* framesDir = nullptr;
+    const char* goldenDir = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--frames") == 0) {
+            framesDir = argv[i + 1];
+        } else if (strcmp(argv[i], "--golden") == 0) {
+            goldenDir = argv[i + 1];
+        }
+    }
+
+    Serial.setMuted(true);
+    setUpNetwork();
+    TimeKeeper::restore();
+
+    printHeader();
+
+    // Parse straight from the (fake) socket, across payload sizes, for both
+    // formats the server may answer with
+    const int holdingCounts[] = {0, 10, 50, 150};
+    for (int holdings : holdingCounts) {
+        std::string json = makePayload(holdings);
+        std::string packed = toMsgPack(json);
+        const FakeResponse responses[] = {
+            {200, json, {{"ETag", "\"bench\""}, {"Content-Type", "application/json"}}, 80},
+            {200, packed, {{"ETag", "\"bench\""}, {"Content-Type", "application/msgpack"}}, 80},
+        };
+
+        CircuitBreaker::beginWake();
+        NetworkManager::connectWiFi();
+        for (const FakeResponse& response : responses) {
+            FakeHttp::setResponse(response);
+            char name[40];
+            snprintf(name, sizeof(name), "fetch %s (%d holdings)",
+                     &response == responses ? "json" : "msgpack", holdings);
+            runBench(name, response.body.size(), 2000, [] {
+                // Each fetch counts as a new wake for the time budget
+                CircuitBreaker::beginWake();
+                GoalData data;
+                NetworkManager::fetchGoalData(data);
+            });
+        }
+        NetworkManager::disconnect();
+    }
+
+    DeltaCase delta = makeDeltaCase();
+    DeltaImages images;
+    images.result.reserve(delta.image.size());
+    runBench("DeltaPatch (48 KB image)", delta.patch.size(), 200, [&] {
+        applyDelta(delta.old, delta.patch, 512, images);
+    });
+
+    // The two dates on screen: data time as parsed, target date as projected
+    runBench("format data time", 0, 100000, [] {
+        char text[DATE_TEXT_SIZE];
+        TimeKeeper::formatLocal(TimeKeeper::parseIsoTime("2025-10-28T11:51:53.666Z"), UPDATE_TIME_FORMAT,
+                                text, sizeof(text));
+    });
+
+    runBench("format target date", 0, 100000, [] {
+        char text[DATE_TEXT_SIZE];
+        TimeKeeper::formatLocal(time(nullptr) + 3750 * 86400, TARGET_DATE_FORMAT, text, sizeof(text));
+    });
+
+    GoalData sample = makeSample();
+
+    runBench("DataStorage::save", 0, 100000, [&sample] {
+        DataStorage::save(sample);
+    });
+
+    runBench("DataStorage::load", 0, 100000, [] {
+        GoalData data;
+        DataStorage::load(data);
+    });
+
+    // All goals in one request
+    std::string batch = makeBatchPayload(GOAL_COUNT);
+    FakeHttp::setResponse({200, batch, {}, 80});
+    CircuitBreaker::beginWake();
+    NetworkManager::connectWiFi();
+    runBench("fetchGoals (batch)", batch.size(), 2000, [] {
+        CircuitBreaker::beginWake();
+        GoalData goals[GOAL_COUNT];
+        uint8_t count = 0;
+        NetworkManager::fetchGoals(goals, GOAL_COUNT, count);
+    });
+    NetworkManager::disconnect();
+
+    // Everything a normal wake does before rendering
+    std::string payload = makePayload(50);
+    FakeHttp::setResponse({200, payload, {{"ETag", "\"bench\""}}, 80});
+    runBench("wake data path (connect+fetch)", payload.size(), 500, [] {
+        CircuitBreaker::beginWake();
+        GoalData data;
+        if (NetworkManager::connectWiFi() && NetworkManager::fetchGoalData(data)) {
+            data.lastUpdateSuccess = true;
+            DataStorage::save(data);
+        }
+        NetworkManager::disconnect();
+    });
+
+    runOutage();
+    runPages();
+    runTimeouts();
+    runBusyWait();
+    runWakeHeap();
+
+    // Every layout, so a change for one panel can't break another
+    int failures = runRender<LAYOUT_416X240>(framesDir, goldenDir) +
+                   runRender<LAYOUT_400X300>(framesDir, goldenDir);
+    if (failures > 0) {
+        printf("\n%d frame(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,86 @@
+// BUSY waits in light sleep against a scripted BUSY line (FakeGpio) and the
+// sleep timer (FakeSleep) (native build only).
+//
+//   pio test -e native -f test_busy_wait
+
+#include <unity.h>
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include "config.h"
+#include "BusyWait.h"
+#include "Fixtures.h"
+#include "TimeKeeper.h"
+
+void setUp() {
+    WiFi.mode(WIFI_OFF);
+}
+
+void tearDown() {
+    WiFi.mode(WIFI_OFF);
+}
+
+// Woken by the edge, not late by a timer slice, for a tenth of the charge
+// of polling
+static void sleepingWaitEndsOnEdge(unsigned long refreshMs) {
+    busyRefresh(false, refreshMs);
+    uint64_t polledCharge = BusyWait::chargeUaMs();
+    unsigned long waitedMs = busyRefresh(true, refreshMs);
+    TEST_ASSERT_EQUAL_UINT32(refreshMs, waitedMs);
+    TEST_ASSERT_LESS_OR_EQUAL(refreshMs / BUSY_WAKE_INTERVAL_MS + 1, BusyWait::stats().sleeps);
+    TEST_ASSERT_TRUE(BusyWait::chargeUaMs() * 10 <= polledCharge);
+}
+
+static void test_full_refresh_ends_on_edge() {
+    sleepingWaitEndsOnEdge(3200);
+}
+
+static void test_partial_refresh_ends_on_edge() {
+    sleepingWaitEndsOnEdge(700);
+}
+
+// A panel that never finishes still hits GxEPD2's timeout
+static void test_stuck_busy_times_out() {
+    unsigned long waitedMs = busyRefresh(true, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(BUSY_TIMEOUT_MS, waitedMs);
+    TEST_ASSERT_LESS_OR_EQUAL(BUSY_TIMEOUT_MS + BUSY_WAKE_INTERVAL_MS, waitedMs);
+}
+
+// No light sleep under a running radio
+static void test_polls_with_wifi_on() {
+    WiFi.mode(WIFI_STA);
+    busyRefresh(true, 700);
+    TEST_ASSERT_EQUAL_UINT(0, BusyWait::stats().sleeps);
+}
+
+// goToSleep: the panel hibernates in light sleep, then the deep-sleep timer
+// is armed; an interval armed before a BUSY wait survives it too
+static void test_sleep_timer_survives_wait() {
+    const uint64_t sleepUs = 15ULL * 60 * 1000000;
+    for (bool armedFirst : {true, false}) {
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+        if (armedFirst) {
+            BusyWait::setSleepTimer(sleepUs);
+        }
+        busyRefresh(true, 100);
+        if (!armedFirst) {
+            BusyWait::setSleepTimer(sleepUs);
+        }
+        const char* message = armedFirst ? "armed before the wait" : "armed after the wait";
+        TEST_ASSERT_TRUE_MESSAGE(FakeSleep::timerWakeUs() == sleepUs, message);
+        TEST_ASSERT_FALSE_MESSAGE(FakeSleep::gpioWake(), message);
+    }
+}
+
+int main(int argc, char** argv) {
+    Serial.setMuted(true);
+    TimeKeeper::restore();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_full_refresh_ends_on_edge);
+    RUN_TEST(test_partial_refresh_ends_on_edge);
+    RUN_TEST(test_stuck_busy_times_out);
+    RUN_TEST(test_polls_with_wifi_on);
+    RUN_TEST(test_sleep_timer_survives_wait);
+    return UNITY_END();
+}
@@ -0,0 +1,51 @@
+// Heap use of a wake: only the network stack may allocate (native build
+// only; every host allocation is counted by HostHeap).
+//
+//   pio test -e native -f test_heap
+
+#include <unity.h>
+#include <Arduino.h>
+#include "config.h"
+#include "Fixtures.h"
+#include "GoalData.h"
+#include "TimeKeeper.h"
+
+void setUp() {
+    setUpNetwork();
+}
+
+void tearDown() {}
+
+static void test_wake_sections_stay_off_the_heap() {
+    std::vector<HeapSection> sections = measureWakeHeap();
+    TEST_ASSERT_GREATER_THAN(0, sections.size());
+    for (const HeapSection& section : sections) {
+        if (section.allocationFree) {
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, section.allocations, section.name);
+        }
+    }
+}
+
+// The two dates on screen and the RTC copy of the goal
+static void test_formatting_and_storage_allocation_free() {
+    GoalData sample = makeSample();
+    uint32_t allocationsBefore = HostHeap::allocations();
+    char text[DATE_TEXT_SIZE];
+    TimeKeeper::formatLocal(TimeKeeper::parseIsoTime("2025-10-28T11:51:53.666Z"), UPDATE_TIME_FORMAT,
+                            text, sizeof(text));
+    TimeKeeper::formatLocal(time(nullptr) + 3750 * 86400, TARGET_DATE_FORMAT, text, sizeof(text));
+    DataStorage::save(sample);
+    GoalData data;
+    DataStorage::load(data);
+    TEST_ASSERT_EQUAL_UINT32(0, HostHeap::allocations() - allocationsBefore);
+}
+
+int main(int argc, char** argv) {
+    Serial.setMuted(true);
+    TimeKeeper::restore();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_wake_sections_stay_off_the_heap);
+    RUN_TEST(test_formatting_and_storage_allocation_free);
+    return UNITY_END();
+}
@@ -0,0 +1,149 @@
+// Data path against the simulated access point and API server: response
+// formats, the conditional GET, the reused DHCP lease and the wake profile
+// header (native build only).
+//
+//   pio test -e native -f test_network
+
+#include <unity.h>
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include "config.h"
+#include "CircuitBreaker.h"
+#include "Fixtures.h"
+#include "GoalData.h"
+#include "NetworkManager.h"
+#include "TimeKeeper.h"
+#include "WakeProfiler.h"
+
+void setUp() {
+    setUpNetwork();
+}
+
+void tearDown() {}
+
+static void assertSameGoal(const GoalData& expected, const GoalData& actual, const char* message) {
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expected.daysToGoal, actual.daysToGoal, message);
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(expected.progressPercent, actual.progressPercent, message);
+    TEST_ASSERT_TRUE_MESSAGE(expected.dataTime == actual.dataTime, message);
+}
+
+// Both answers to "Accept: application/msgpack" (MessagePack, or JSON from a
+// server without support) give the same goal, also when the body arrives in
+// TCP segments with gaps between them
+static void test_formats_give_the_same_goal() {
+    std::string json = makePayload(10);
+    std::string packed = toMsgPack(json);
+    const struct {
+        const char* name;
+        FakeResponse response;
+    } responses[] = {
+        {"JSON", {200, json, {{"Content-Type", "application/json; charset=utf-8"}}, 80}},
+        {"MessagePack", {200, packed, {{"Content-Type", "application/msgpack"}}, 80}},
+        {"segmented JSON", {200, json, {{"Content-Type", "application/json"}}, 80, 100, 30}},
+        {"segmented MessagePack", {200, packed, {{"Content-Type", "application/msgpack"}}, 80, 100, 30}},
+    };
+
+    CircuitBreaker::beginWake();
+    NetworkManager::connectWiFi();
+    GoalData results[4];
+    for (int i = 0; i < 4; i++) {
+        FakeHttp::setResponse(responses[i].response);
+        TEST_ASSERT_TRUE_MESSAGE(NetworkManager::fetchGoalData(results[i]), responses[i].name);
+    }
+    NetworkManager::disconnect();
+
+    for (int i = 1; i < 4; i++) {
+        assertSameGoal(results[0], results[i], responses[i].name);
+    }
+}
+
+static void test_msgpack_requested() {
+    CircuitBreaker::beginWake();
+    NetworkManager::connectWiFi();
+    GoalData data;
+    FakeHttp::setResponse({200, makePayload(0), {{"Content-Type", "application/json"}}, 80});
+    NetworkManager::fetchGoalData(data);
+    NetworkManager::disconnect();
+
+    String accept = FakeHttp::lastRequestHeader("Accept");
+    TEST_ASSERT_EQUAL(PREFER_MSGPACK, strncmp(accept.c_str(), "application/msgpack", 19) == 0);
+}
+
+// A 200 stores its validators; the next request sends them, and a 304
+// reuses the cached goal as fresh data without reading the body
+static void test_not_modified_reuses_cache() {
+    const char* etag = "\"v2-not-modified\"";
+    const char* lastModified = "Tue, 28 Oct 2025 11:51:53 GMT";
+    FakeHttp::setResponse({200, makePayload(10), {{"ETag", etag}, {"Last-Modified", lastModified},
+                                                  {"Content-Type", "application/json"}}, 80});
+    GoalData fresh{};
+    TEST_ASSERT_TRUE_MESSAGE(fetchAndStore(fresh), "first response not parsed");
+    GoalData cached;
+    DataStorage::load(cached);
+
+    // A body on the 304 would be a different goal, if anything read it
+    delay(60UL * 1000);
+    FakeHttp::setResponse({304, makePayload(50), {}, 80});
+    GoalData data{};
+    bool fetched = fetchAndStore(data);
+    GoalData stored;
+    DataStorage::load(stored);
+
+    TEST_ASSERT_EQUAL_STRING(etag, FakeHttp::lastRequestHeader("If-None-Match").c_str());
+    TEST_ASSERT_EQUAL_STRING(lastModified, FakeHttp::lastRequestHeader("If-Modified-Since").c_str());
+    TEST_ASSERT_TRUE_MESSAGE(fetched, "304 not taken as fresh data");
+    TEST_ASSERT_TRUE_MESSAGE(data.lastUpdateSuccess, "304 shown as offline");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(0, FakeHttp::bodyBytesRead(), "304 body read");
+    TEST_ASSERT_TRUE_MESSAGE(sameGoal(cached, data), "goal differs from the cached one");
+    TEST_ASSERT_TRUE_MESSAGE(sameGoal(cached, stored), "RTC copy changed");
+}
+
+// The DHCP lease is reused as a static IP until it is WIFI_STATIC_IP_MAX_AGE
+// old, then renewed
+static void test_lease_renewed_by_age() {
+    const unsigned int expected[3] = {1, 0, 1};
+    for (int wake = 0; wake < 3; wake++) {
+        // An hour after a DHCP wake, else once any lease has expired
+        delay(wake == 1 ? 3600UL * 1000 : WIFI_STATIC_IP_MAX_AGE * 1000UL);
+        // Deep sleep drops the static config
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+        unsigned int before = FakeWiFi::dhcpCount();
+        CircuitBreaker::beginWake();
+        NetworkManager::connectWiFi();
+        NetworkManager::disconnect();
+        TEST_ASSERT_EQUAL_UINT(expected[wake], FakeWiFi::dhcpCount() - before);
+    }
+}
+
+// A full ring of records with every field at its longest fits the buffer
+// the request header is built in
+static void test_wake_profile_fits_header() {
+    for (uint8_t wake = 0; wake < WAKE_PROFILE_HISTORY; wake++) {
+        WakeProfiler::begin();
+        for (uint8_t phase = 0; phase < PHASE_COUNT; phase++) {
+            WakeProfiler::start((WakePhase)phase);
+            delay(70000);
+            WakeProfiler::stop((WakePhase)phase);
+        }
+        WakeProfiler::setRssi(-128);
+        WakeProfiler::commit();
+    }
+    char profile[WAKE_PROFILE_TEXT_SIZE];
+    size_t length = WakeProfiler::formatPending(profile, sizeof(profile));
+    WakeProfiler::clearPending();
+    TEST_ASSERT_GREATER_THAN(0, length);
+}
+
+int main(int argc, char** argv) {
+    Serial.setMuted(true);
+    TimeKeeper::restore();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_formats_give_the_same_goal);
+    RUN_TEST(test_msgpack_requested);
+    RUN_TEST(test_not_modified_reuses_cache);
+    RUN_TEST(test_lease_renewed_by_age);
+    RUN_TEST(test_wake_profile_fits_header);
+    return UNITY_END();
+}
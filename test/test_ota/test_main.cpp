@@ -0,0 +1,163 @@
+// Firmware updates: the streaming delta patcher, and OtaUpdater against the
+// simulated flash (FakeFlash) and API server (native build only).
+//
+//   pio test -e native -f test_ota
+
+#include <unity.h>
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <esp_ota_ops.h>
+#include "config.h"
+#include "CircuitBreaker.h"
+#include "DeltaPatch.h"
+#include "Fixtures.h"
+#include "GoalData.h"
+#include "NetworkManager.h"
+#include "OtaUpdater.h"
+#include "TimeKeeper.h"
+
+// Only a pinned HTTPS server with a signing key is a source
+static const char* API = "https://bench.test/api/portfolio/summary";
+static const char* PIN = "00:11:22:33:44:55:66:77:88:99:AA:BB:CC:DD:EE:FF:00:11:22:33:44:55:66:77:88:99:AA:BB:CC:DD:EE:FF";
+static const char* KEY = "-----BEGIN PUBLIC KEY-----";
+static const char* SIGNATURE = "3045022100aa022000bb";  // form only on the host
+static const char* PATCH_PATH = "/firmware/" FIRMWARE_VERSION "/9.9.9.gtd";
+
+void setUp() {
+    setUpNetwork();
+}
+
+void tearDown() {
+    OtaUpdater::setSource(OTA_ENABLED ? API_URL : "", API_CERT_SHA256, OTA_PUBLIC_KEY);
+}
+
+// The same image whatever the chunking, and no heap
+static void test_patch_applied_in_any_chunks() {
+    DeltaCase test = makeDeltaCase();
+    DeltaImages images;
+    images.result.reserve(test.image.size());
+
+    const size_t chunks[] = {test.patch.size(), 512, 1};
+    for (size_t chunk : chunks) {
+        char message[48];
+        snprintf(message, sizeof(message), "%zu byte chunks", chunk);
+        uint32_t allocationsBefore = HostHeap::allocations();
+        DeltaPatch::Result result = applyDelta(test.old, test.patch, chunk, images);
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, HostHeap::allocations() - allocationsBefore, message);
+        TEST_ASSERT_EQUAL_MESSAGE(DeltaPatch::PATCH_DONE, result, message);
+        TEST_ASSERT_TRUE_MESSAGE(images.result == test.image, message);
+    }
+}
+
+// A wrong base or a corrupted patch is an error, a truncated one never done
+static void test_patch_rejects_bad_input() {
+    DeltaCase test = makeDeltaCase();
+    DeltaImages images;
+    std::string otherBase = test.old;
+    otherBase[20000] ^= 1;
+    std::string corrupted = test.patch;
+    corrupted[corrupted.size() - 10] ^= 1;
+    std::string truncated = test.patch.substr(0, test.patch.size() - 1);
+
+    TEST_ASSERT_EQUAL_MESSAGE(DeltaPatch::PATCH_ERROR, applyDelta(otherBase, test.patch, 512, images),
+                              "patch applied to a different base image");
+    TEST_ASSERT_TRUE_MESSAGE(images.result.empty(), "image written from a different base");
+    TEST_ASSERT_EQUAL_MESSAGE(DeltaPatch::PATCH_ERROR, applyDelta(test.old, corrupted, 512, images),
+                              "corrupted patch accepted");
+    TEST_ASSERT_EQUAL_MESSAGE(DeltaPatch::PATCH_MORE, applyDelta(test.old, truncated, 512, images),
+                              "truncated patch not detected");
+}
+
+static void test_offer_needs_secure_source_and_signature() {
+    OtaUpdater::setSource("http://bench.test/api/portfolio/summary", PIN, KEY);
+    OtaUpdater::offer("9.9.9", PATCH_PATH, SIGNATURE);
+    TEST_ASSERT_FALSE_MESSAGE(OtaUpdater::hasOffer(), "offer over plain HTTP");
+    OtaUpdater::setSource(API, "", KEY);
+    OtaUpdater::offer("9.9.9", PATCH_PATH, SIGNATURE);
+    TEST_ASSERT_FALSE_MESSAGE(OtaUpdater::hasOffer(), "offer from an unpinned server");
+    OtaUpdater::setSource(API, PIN, KEY);
+    OtaUpdater::offer("9.9.9", PATCH_PATH, nullptr);
+    TEST_ASSERT_FALSE_MESSAGE(OtaUpdater::hasOffer(), "unsigned offer");
+}
+
+// Patches and the token stay on the API server
+static void test_patch_only_from_api_server() {
+    FakeFlash::reset(makeDeltaCase().old);
+    OtaUpdater::setSource(API, PIN, KEY);
+    FakeHttp::setRoute(PATCH_PATH, {200, makeDeltaCase().patch, {}, 400});
+    OtaUpdater::offer("9.9.9", "https://bench.test.evil.example/9.9.9.gtd", SIGNATURE);
+    TEST_ASSERT_FALSE(OtaUpdater::apply());
+    OtaUpdater::offer("9.9.9", "https://bench.test@evil.example/9.9.9.gtd", SIGNATURE);
+    TEST_ASSERT_FALSE(OtaUpdater::apply());
+    TEST_ASSERT_EQUAL_UINT(0, FakeHttp::requestCount());
+}
+
+// An offer in the API response is downloaded and applied into the other
+// app slot; an image that never fetches is rolled back after
+// OTA_TRIAL_WAKES wakes and its version isn't taken again, one that fetches
+// is kept
+static void test_update_rolled_back_or_kept() {
+    DeltaCase test = makeDeltaCase();
+    FakeFlash::reset(test.old);
+    const esp_partition_t* original = esp_ota_get_running_partition();
+    OtaUpdater::setSource(API, PIN, KEY);
+
+    std::string json = makePayload(0);
+    json.insert(1, std::string("\"firmware\":{\"version\":\"9.9.9\",\"url\":\"") + PATCH_PATH +
+                       "\",\"signature\":\"" + SIGNATURE + "\"},");
+    FakeHttp::setResponse({200, json, {{"Content-Type", "application/json"}}, 80});
+    FakeHttp::setRoute(PATCH_PATH, {200, test.patch, {}, 400});
+
+    CircuitBreaker::beginWake();
+    NetworkManager::connectWiFi();
+    GoalData data;
+    NetworkManager::fetchGoalData(data);
+    TEST_ASSERT_EQUAL_STRING(FIRMWARE_VERSION, FakeHttp::lastRequestHeader("X-Firmware-Version").c_str());
+    TEST_ASSERT_TRUE_MESSAGE(OtaUpdater::hasOffer(), "update not offered");
+    bool applied = OtaUpdater::apply();
+    NetworkManager::disconnect();
+    TEST_ASSERT_TRUE_MESSAGE(applied, "update not applied");
+    // The patch path is relative to the API server
+    std::string patchUrl = std::string("https://bench.test") + PATCH_PATH;
+    TEST_ASSERT_EQUAL_STRING(patchUrl.c_str(), FakeHttp::lastUrl().c_str());
+    const esp_partition_t* updated = esp_ota_get_boot_partition();
+    TEST_ASSERT_TRUE_MESSAGE(updated != original, "boot slot unchanged");
+    TEST_ASSERT_EQUAL_INT(0, FakeFlash::image(updated).compare(0, test.image.size(), test.image));
+
+    // The new image boots and never fetches
+    esp_restart();
+    for (int wake = 0; wake <= OTA_TRIAL_WAKES; wake++) {
+        OtaUpdater::begin();
+    }
+    OtaUpdater::offer("9.9.9", PATCH_PATH, SIGNATURE);
+    TEST_ASSERT_TRUE_MESSAGE(esp_ota_get_running_partition() == original, "failed update not rolled back");
+    TEST_ASSERT_FALSE_MESSAGE(OtaUpdater::hasOffer(), "rolled back version offered again");
+
+    // A newer one fetches on its first wake
+    CircuitBreaker::beginWake();
+    NetworkManager::connectWiFi();
+    OtaUpdater::offer("9.9.10", PATCH_PATH, SIGNATURE);
+    OtaUpdater::apply();
+    NetworkManager::disconnect();
+    esp_restart();
+    OtaUpdater::begin();
+    OtaUpdater::confirm();
+    for (int wake = 0; wake <= OTA_TRIAL_WAKES; wake++) {
+        OtaUpdater::begin();
+    }
+    TEST_ASSERT_TRUE_MESSAGE(esp_ota_get_running_partition() == updated, "confirmed update not kept");
+    TEST_ASSERT_TRUE(FakeFlash::validated());
+}
+
+int main(int argc, char** argv) {
+    Serial.setMuted(true);
+    TimeKeeper::restore();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_patch_applied_in_any_chunks);
+    RUN_TEST(test_patch_rejects_bad_input);
+    RUN_TEST(test_offer_needs_secure_source_and_signature);
+    RUN_TEST(test_patch_only_from_api_server);
+    RUN_TEST(test_update_rolled_back_or_kept);
+    return UNITY_END();
+}
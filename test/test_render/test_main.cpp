@@ -0,0 +1,137 @@
+// Goal screen drawn into an offscreen FrameCanvas for both layouts: every
+// change between two frames lies inside the partial-refresh window
+// DisplayManager would use, and the prerendered bitmaps match the fonts
+// (native build only).
+//
+//   pio test -e native -f test_render
+
+#include <unity.h>
+#include <Arduino.h>
+#include <vector>
+#include "config.h"
+#include "DisplayLayout.h"
+#include "Fixtures.h"
+#include "FrameCanvas.h"
+#include "GoalData.h"
+#include "GoalRenderer.h"
+#include "TimeKeeper.h"
+
+void setUp() {
+    GoalRenderer::setPrerendered(false);
+}
+
+void tearDown() {}
+
+// Each step of makeRenderSteps() changes only pixels inside the window
+// given by the regions whose signature changed
+template <const DisplayLayout& L>
+static void changesInsideWindow() {
+    FrameCanvas canvas(L.width, L.height);
+    std::vector<uint8_t> previous(canvas.frameBytes());
+    std::vector<uint8_t> frame(canvas.frameBytes());
+    FrameSignature lastSignature = {};
+    std::vector<RenderStep> steps = makeRenderSteps();
+    for (size_t i = 0; i < steps.size(); i++) {
+        GoalRenderer::draw<L>(canvas, steps[i].data);
+        canvas.exportBits(frame.data());
+        FrameSignature signature = GoalRenderer::makeSignature<L>(steps[i].data);
+        if (i > 0) {
+            GoalRenderer::Rect changed = canvas.diffBounds(previous.data(), frame.data());
+            uint8_t dirty = GoalRenderer::dirtyRegions(lastSignature, signature);
+            GoalRenderer::Rect window = GoalRenderer::dirtyBounds<L>(dirty);
+            char message[128];
+            snprintf(message, sizeof(message), "%s: changed %dx%d at %d,%d, window %dx%d at %d,%d",
+                     steps[i].name, changed.w, changed.h, changed.x, changed.y, window.w, window.h,
+                     window.x, window.y);
+            TEST_ASSERT_TRUE_MESSAGE(contains(window, changed), message);
+        }
+        lastSignature = signature;
+        previous.swap(frame);
+    }
+}
+
+// The error icon on its own: going offline also changes the footer, whose
+// full-width window would hide an icon region that is too small
+template <const DisplayLayout& L>
+static void errorIconInsideItsRegion() {
+    FrameCanvas canvas(L.width, L.height);
+    std::vector<uint8_t> online(canvas.frameBytes());
+    std::vector<uint8_t> offline(canvas.frameBytes());
+    GoalData data = makeSample();
+    GoalRenderer::draw<L>(canvas, data);
+    canvas.exportBits(online.data());
+    data.lastUpdateSuccess = false;
+    GoalRenderer::draw<L>(canvas, data);
+    canvas.exportBits(offline.data());
+
+    GoalRenderer::Rect footer = GoalRenderer::regionRect<L>(GoalRenderer::REGION_FOOTER);
+    size_t rowBytes = (L.width + 7) / 8;
+    for (int y = max((int)footer.y, 0); y < min(footer.y + footer.h, (int)L.height); y++) {
+        memset(online.data() + y * rowBytes, 0, rowBytes);
+        memset(offline.data() + y * rowBytes, 0, rowBytes);
+    }
+    GoalRenderer::Rect icon = canvas.diffBounds(online.data(), offline.data());
+    GoalRenderer::Rect window = GoalRenderer::regionRect<L>(GoalRenderer::REGION_ERROR_ICON);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0, icon.w, "no error icon drawn");
+    TEST_ASSERT_TRUE_MESSAGE(contains(window, icon), "error icon outside REGION_ERROR_ICON");
+}
+
+// The prerendered bitmaps give exactly the pixels of the fonts
+template <const DisplayLayout& L>
+static void prerenderedMatchesFonts() {
+#ifdef GOAL_PRERENDERED
+    FrameCanvas canvas(L.width, L.height);
+    std::vector<uint8_t> fonts(canvas.frameBytes());
+    std::vector<uint8_t> prerendered(canvas.frameBytes());
+    for (const RenderStep& step : makeRenderSteps()) {
+        GoalRenderer::setPrerendered(false);
+        GoalRenderer::draw<L>(canvas, step.data);
+        canvas.exportBits(fonts.data());
+        GoalRenderer::setPrerendered(true);
+        GoalRenderer::draw<L>(canvas, step.data);
+        canvas.exportBits(prerendered.data());
+        GoalRenderer::Rect d = canvas.diffBounds(fonts.data(), prerendered.data());
+        TEST_ASSERT_EQUAL_INT_MESSAGE(0, d.w, step.name);
+    }
+#else
+    TEST_IGNORE_MESSAGE("prerendered bitmaps not built (see tools/prerender.py)");
+#endif
+}
+
+static void test_changes_inside_window_416x240() {
+    changesInsideWindow<LAYOUT_416X240>();
+}
+
+static void test_changes_inside_window_400x300() {
+    changesInsideWindow<LAYOUT_400X300>();
+}
+
+static void test_error_icon_inside_its_region_416x240() {
+    errorIconInsideItsRegion<LAYOUT_416X240>();
+}
+
+static void test_error_icon_inside_its_region_400x300() {
+    errorIconInsideItsRegion<LAYOUT_400X300>();
+}
+
+static void test_prerendered_matches_fonts_416x240() {
+    prerenderedMatchesFonts<LAYOUT_416X240>();
+}
+
+static void test_prerendered_matches_fonts_400x300() {
+    prerenderedMatchesFonts<LAYOUT_400X300>();
+}
+
+int main(int argc, char** argv) {
+    Serial.setMuted(true);
+    TimeKeeper::restore();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_changes_inside_window_416x240);
+    RUN_TEST(test_changes_inside_window_400x300);
+    RUN_TEST(test_error_icon_inside_its_region_416x240);
+    RUN_TEST(test_error_icon_inside_its_region_400x300);
+    RUN_TEST(test_prerendered_matches_fonts_416x240);
+    RUN_TEST(test_prerendered_matches_fonts_400x300);
+    return UNITY_END();
+}
@@ -0,0 +1,80 @@
+// Learned connect and HTTP timeouts over hourly wakes against an API with
+// jittered latency that hangs, recovers and slows down (native build only).
+//
+//   pio test -e native -f test_timeouts
+
+#include <unity.h>
+#include <Arduino.h>
+#include <WiFi.h>
+#include <string.h>
+#include "config.h"
+#include "AdaptiveTimeout.h"
+#include "Fixtures.h"
+#include "TimeKeeper.h"
+
+void setUp() {
+    setUpNetwork();
+    AdaptiveTimeout::relearn();
+}
+
+void tearDown() {}
+
+// A steady network never times out, a hanging API costs less than half its
+// fixed timeouts, and a slower API is relearned after one timeout
+static void test_timeouts_follow_the_api() {
+    std::string payload = makePayload(10);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < TIMEOUT_STEPS_COUNT; i++) {
+        const TimeoutStep& step = TIMEOUT_STEPS[i];
+        unsigned timeouts = 0;
+        unsigned long radioMs = 0;
+        for (unsigned wake = 0; wake < step.wakes; wake++) {
+            timeouts += timeoutWake(payload, step.latencyMs, seed, radioMs) ? 1 : 0;
+        }
+        unsigned long httpTimeout = AdaptiveTimeout::get(TIMEOUT_HTTP);
+        unsigned long ceilingMs = AdaptiveTimeout::ceilingMs(TIMEOUT_HTTP);
+
+        if (strcmp(step.name, "steady") == 0 || strcmp(step.name, "recovered") == 0) {
+            // Jitter alone never times out, and the timeout is learned
+            TEST_ASSERT_EQUAL_UINT_MESSAGE(0, timeouts, step.name);
+            if (ADAPTIVE_TIMEOUTS) {
+                TEST_ASSERT_LESS_THAN_MESSAGE(ceilingMs, httpTimeout, step.name);
+            }
+        } else if (strcmp(step.name, "hangs") == 0) {
+            if (ADAPTIVE_TIMEOUTS) {
+                TEST_ASSERT_LESS_THAN_MESSAGE(step.wakes * ceilingMs / 2, radioMs, step.name);
+            }
+        } else if (strcmp(step.name, "10x slower") == 0) {
+            // The probe after the first timeout relearns the phase
+            TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(1, timeouts, step.name);
+            TEST_ASSERT_GREATER_THAN_MESSAGE(step.latencyMs + step.latencyMs / 4, httpTimeout, step.name);
+        }
+    }
+}
+
+// Another access point: what was learned on the old one doesn't count
+static void test_new_access_point_starts_over() {
+    std::string payload = makePayload(10);
+    uint32_t seed = 1;
+    unsigned long radioMs = 0;
+    for (unsigned wake = 0; wake < TIMEOUT_MIN_SAMPLES; wake++) {
+        timeoutWake(payload, 300, seed, radioMs);
+    }
+    TEST_ASSERT_GREATER_THAN(1, AdaptiveTimeout::samples(TIMEOUT_HTTP));
+
+    FakeWiFi::reset();
+    FakeWiFi::addAccessPoint({WIFI_SSID, {0x24, 0x0A, 0xC4, 0x77, 0x77, 0x77}, 1, -60});
+    timeoutWake(payload, 300, seed, radioMs);
+    TEST_ASSERT_LESS_OR_EQUAL(1, AdaptiveTimeout::samples(TIMEOUT_HTTP));
+    TEST_ASSERT_LESS_OR_EQUAL(1, AdaptiveTimeout::samples(TIMEOUT_ASSOCIATE_SCAN));
+}
+
+int main(int argc, char** argv) {
+    Serial.setMuted(true);
+    TimeKeeper::restore();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_timeouts_follow_the_api);
+    RUN_TEST(test_new_access_point_starts_over);
+    return UNITY_END();
+}
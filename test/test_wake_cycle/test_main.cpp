@@ -0,0 +1,145 @@
+// Wake cycles on the virtual clock: the failure budget through a week of
+// outages, the radio wakes of a normal day and the local countdown between
+// fetches (native build only).
+//
+//   pio test -e native -f test_wake_cycle
+
+#include <unity.h>
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include "config.h"
+#include "CircuitBreaker.h"
+#include "Fixtures.h"
+#include "GoalData.h"
+#include "GoalRenderer.h"
+#include "TimeKeeper.h"
+#include "WakeScheduler.h"
+
+void setUp() {
+    setUpNetwork();
+}
+
+void tearDown() {}
+
+// Through OUTAGE_WEEK the fetch backoff grows up to its cap, no wake
+// overruns its time budget, the offline marker is drawn from the
+// OFFLINE_REDRAW_AFTER-th failed wake on, and the WiFi/HTTP breakers open
+// during the outage and close after it
+static void test_outage_week() {
+    const uint32_t baseSeconds = UPDATE_INTERVAL / 1000;
+    const uint32_t capSeconds = max((uint32_t)(MAX_BACKOFF_INTERVAL / 1000), baseSeconds);
+    std::string payload = makePayload(10);
+    char message[96];
+
+    time_t dayEnd = time(nullptr);
+    FrameSignature lastSignature = {};
+    uint32_t lastBackoff = 0;
+    unsigned iconRedraws = 0;
+    bool reachedCap = false;
+    bool breakersOpened = false;
+    for (size_t day = 0; day < OUTAGE_WEEK_DAYS; day++) {
+        setUpOutageDay(OUTAGE_WEEK[day], payload);
+
+        unsigned wakes = 0, fetched = 0;
+        dayEnd += 86400;
+        while (time(nullptr) < dayEnd) {
+            SimulatedWake wake = simulateWake();
+            fetched += wake.fetched ? 1 : 0;
+            wakes++;
+            snprintf(message, sizeof(message), "day %u (%s), wake %u", (unsigned)day,
+                     OUTAGE_WEEK[day].condition, wakes);
+            TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(WAKE_TIME_BUDGET, wake.awakeMs, message);
+
+            // The error icon shows from the OFFLINE_REDRAW_AFTER-th failed
+            // wake on, so the screen is refreshed once going offline and
+            // once coming back
+            FrameSignature signature = GoalRenderer::makeSignature<DISPLAY_LAYOUT>(wake.shown);
+            uint16_t failedWakes = CircuitBreaker::failedWakes();
+            TEST_ASSERT_EQUAL_MESSAGE(failedWakes >= OFFLINE_REDRAW_AFTER, signature.errorIcon, message);
+            if (wakes > 1 || day > 0) {
+                iconRedraws += (GoalRenderer::dirtyRegions(lastSignature, signature) &
+                                GoalRenderer::REGION_ERROR_ICON) != 0;
+            }
+            lastSignature = signature;
+
+            uint32_t backoff = CircuitBreaker::backoffSeconds(baseSeconds);
+            TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(capSeconds, backoff, message);
+            if (failedWakes > 1 && backoff != capSeconds) {
+                TEST_ASSERT_GREATER_THAN_MESSAGE(lastBackoff, backoff, message);
+            }
+            reachedCap |= backoff == capSeconds;
+            lastBackoff = backoff;
+            breakersOpened |= CircuitBreaker::isOpen(BREAKER_WIFI) && CircuitBreaker::isOpen(BREAKER_HTTP);
+            simulateSleep();
+        }
+
+        // A day of outage at the capped backoff has few wakes
+        if (fetched == 0 && lastBackoff == capSeconds && day > 1) {
+            snprintf(message, sizeof(message), "day %u (%s)", (unsigned)day, OUTAGE_WEEK[day].condition);
+            TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(86400 / capSeconds + 1, wakes, message);
+        }
+    }
+    TEST_ASSERT_TRUE_MESSAGE(reachedCap, "backoff never reached MAX_BACKOFF_INTERVAL");
+    TEST_ASSERT_EQUAL_UINT_MESSAGE(2, iconRedraws, "error icon redraws");
+    TEST_ASSERT_TRUE_MESSAGE(breakersOpened, "WiFi/HTTP breakers never opened");
+    TEST_ASSERT_EQUAL_UINT(0, CircuitBreaker::failedWakes());
+    TEST_ASSERT_FALSE(CircuitBreaker::isOpen(BREAKER_WIFI));
+    TEST_ASSERT_FALSE(CircuitBreaker::isOpen(BREAKER_HTTP));
+}
+
+// A day of wakes with the batched API turns the radio on only for the
+// fetches that are due, and never shows the goals as offline
+static void test_pages_radio_wakes() {
+    FakeHttp::setResponse({200, makeBatchPayload(GOAL_COUNT), {}, 80});
+
+    unsigned wakes = 0, radioWakes = 0, offlineWakes = 0;
+    time_t dayEnd = time(nullptr) + 86400;
+    while (time(nullptr) < dayEnd) {
+        SimulatedWake wake = simulateWake();
+        TEST_ASSERT_LESS_OR_EQUAL(WAKE_TIME_BUDGET, wake.awakeMs);
+        wakes++;
+        radioWakes += wake.usedRadio ? 1 : 0;
+        offlineWakes += wake.shown.lastUpdateSuccess ? 0 : 1;
+        simulateSleep();
+    }
+
+    unsigned maxRadioWakes;
+    if (FETCH_INTERVAL > 0) {
+        maxRadioWakes = 86400 / (FETCH_INTERVAL / 1000) + 1;
+    } else {
+        maxRadioWakes = GOAL_COUNT > 1 ? wakes / FETCH_EVERY_WAKES + 1 : wakes;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(maxRadioWakes, radioWakes);
+    TEST_ASSERT_EQUAL_UINT(0, offlineWakes);
+}
+
+// Wakes between fetches count the days down from the cached data and are
+// planned to land just after local midnight
+static void test_countdown_between_fetches() {
+    if (FETCH_INTERVAL == 0) {
+        TEST_IGNORE_MESSAGE("FETCH_INTERVAL is 0, no local updates");
+    }
+    GoalData sample = makeSample();
+    DataStorage::save(sample);
+    for (int day = 1; day <= 3; day++) {
+        delay(86400UL * 1000);
+        GoalData data;
+        DataStorage::load(data);
+        TEST_ASSERT_EQUAL_INT(sample.daysToGoal - day, data.daysToGoal);
+    }
+
+    time_t now = time(nullptr);
+    uint32_t sleepSeconds = WakeScheduler::planSleep();
+    TEST_ASSERT_LESS_OR_EQUAL(TimeKeeper::localDay(now) + 1, TimeKeeper::localDay(now + sleepSeconds));
+}
+
+int main(int argc, char** argv) {
+    Serial.setMuted(true);
+    TimeKeeper::restore();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_outage_week);
+    RUN_TEST(test_pages_radio_wakes);
+    RUN_TEST(test_countdown_between_fetches);
+    return UNITY_END();
+}
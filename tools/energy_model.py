@@ -0,0 +1,448 @@
+#!/usr/bin/env python3
+"""Energy and battery-life model of the wake cycle.
+
+Simulates days of wake cycles with the schedule and failure handling in
+include/config.h, a per-phase current profile of the ESP32-C3 board and the
+e-ink panel, and per-phase durations. Prints wakes, mAh/day and projected
+battery life for normal operation and for outages:
+
+    python3 tools/energy_model.py --capacity 1000
+    python3 tools/energy_model.py --log wakes.txt --breakdown
+    python3 tools/energy_model.py --profile currents.json --set UPDATE_INTERVAL=1800000
+
+Durations are assumptions (DURATIONS below) unless --log is given: a file
+with the "wake: ..." lines printed by tools/mock_server.py, or raw
+X-Wake-Profile header values. The median of each phase in the log replaces
+the assumed value. The current profile is a JSON object with any of the
+keys of CURRENTS (mA); measure your own board for real numbers.
+
+Compare a change to connectWiFi / syncTime / fetchGoalData / showGoalInfo in
+battery terms by running the model on logs from before and after it.
+"""
+
+import argparse
+import json
+import os
+import re
+import statistics
+import sys
+
+PHASES = ["boot", "display", "scan", "assoc", "ntp", "http", "parse", "render", "hibernate"]
+
+# Average current of the whole board per phase (mA at the battery, 3.7 V),
+# rough datasheet figures for an ESP32-C3 Super Mini with the panel on GPIO8.
+# "display" is the panel's power-up, which overlaps the network phases, so
+# it only counts the panel's share.
+CURRENTS = {
+    "sleep": 0.06,       # deep sleep: chip ~5 uA plus regulator and LED leakage
+    "boot": 22.0,        # CPU at 160 MHz, radio off
+    "display": 3.0,      # panel power-up and init on top of the CPU
+    "scan": 85.0,        # radio receiving
+    "assoc": 95.0,
+    "ntp": 75.0,
+    "http": 75.0,
+    "tls": 80.0,         # handshake: radio on plus crypto
+    "parse": 70.0,       # radio still on until the data is in
+    "render": 27.0,      # CPU waiting on BUSY plus the panel's booster
+    "busy_sleep": 5.2,   # the same wait in light sleep (BUSY_LIGHT_SLEEP)
+    "hibernate": 22.0,
+}
+
+# Assumed phase durations (ms) of the wake paths in src/main.cpp
+DURATIONS = {
+    "boot": 150,
+    "console_wait": 1000,      # added to boot in debug builds (DEBUG_MODE)
+    "display": 300,
+    "assoc": 350,              # cached AP, static IP
+    "scan_channel": 120,       # one channel, when the cached AP failed
+    "scan_full": 2600,         # all channels
+    "assoc_scan": 1500,        # connect after a scan, with DHCP
+    "ntp": 120,
+    "http": 350,
+    "http_error": 300,         # answered with an error status
+    "http_timeout": 10000,     # request timeout in NetworkManager::fetchGoals
+    "http_timeout_learned": 1500,   # ADAPTIVE_TIMEOUTS: the floors, normal
+    "assoc_timeout_learned": 1000,  # latencies give shorter ones
+    "tls_full": 1400,          # HTTPS only
+    "tls_resumed": 300,
+    "parse": 15,
+    "render_partial": 700,     # partial refresh incl. drawing
+    "render_full": 3200,
+    "draw": 150,               # of a refresh: drawing and sending the frame, before BUSY
+    "hibernate": 110,          # includes the 100 ms delay before deep sleep
+}
+
+# With ADAPTIVE_TIMEOUTS every TIMEOUT_PROBE_EVERY-th wait of a phase that
+# keeps timing out gets the fixed timeout (include/AdaptiveTimeout.h)
+TIMEOUT_PROBE_EVERY = 4
+
+# Daily conditions, like the bench's outage simulation
+SCENARIOS = {
+    "normal": [("normal", True, "ok")],
+    "ap-down": [("AP down", False, "ok")],
+    "api-hangs": [("API hangs", True, "hang")],
+    "api-503": [("API 503", True, "error")],
+    "outage-week": [
+        ("normal", True, "ok"),
+        ("AP down", False, "ok"),
+        ("AP down", False, "ok"),
+        ("AP down", False, "ok"),
+        ("API hangs", True, "hang"),
+        ("API 503", True, "error"),
+        ("normal", True, "ok"),
+    ],
+}
+
+
+def find_config():
+    root = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include")
+    for name in ("config.h", "config.example.h"):
+        path = os.path.join(root, name)
+        if os.path.exists(path):
+            return path
+    return None
+
+
+def parse_value(text):
+    text = text.strip()
+    if text in ("true", "false"):
+        return text == "true"
+    if text.startswith('"'):
+        return text.strip('"')
+    expression = re.sub(r"\b(\d+)[uUlL]+\b", r"\1", text)
+    if re.fullmatch(r"[\d\s+\-*/().]+", expression):
+        return eval(expression, {"__builtins__": {}})
+    return text
+
+
+def read_config(path):
+    """constexpr and #define values of config.h (numbers, bools and strings)."""
+    with open(path) as file:
+        text = re.sub(r"//.*", "", file.read())
+    values = {}
+    for name, value in re.findall(r"constexpr\s+[\w\s*]+?\b(\w+)\s*=\s*([^;]+);", text):
+        values[name] = parse_value(value)
+    for name, value in re.findall(r"^\s*#define\s+(\w+)[ \t]+([^\n]+)", text, re.M):
+        values.setdefault(name, parse_value(value))
+    return values
+
+
+def resolve(config):
+    """Values defined as another bool, like BUSY_LIGHT_SLEEP = !DEBUG_MODE."""
+    for name, value in config.items():
+        match = re.fullmatch(r"\(?\s*(!?)\s*(\w+)\s*\)?", value) if isinstance(value, str) else None
+        if match and isinstance(config.get(match.group(2)), bool):
+            config[name] = config[match.group(2)] != bool(match.group(1))
+
+
+def read_log(path):
+    """Phase durations of each wake in a log, as dicts phase -> ms."""
+    wakes = []
+    with open(path) as file:
+        for line in file:
+            if "wake:" in line:
+                fields = dict(re.findall(r"(\w+)=(\d+)", line))
+                wakes.append({phase: int(fields.get(phase, 0)) for phase in PHASES})
+                continue
+            match = re.search(r"\b1;([\d,.|-]+)", line)
+            if match:
+                for record in match.group(1).split("|"):
+                    parts = record.split(",")
+                    if len(parts) == 5:
+                        timings = [int(value) for value in parts[4].split(".")]
+                        wakes.append(dict(zip(PHASES, timings)))
+    return wakes
+
+
+def apply_log(durations, wakes):
+    """Replaces assumed durations by the medians of the logged wakes."""
+    measured = {}
+
+    def median(phase, select=lambda ms: ms > 0):
+        values = [wake[phase] for wake in wakes if select(wake[phase])]
+        return int(statistics.median(values)) if values else None
+
+    mapping = {"boot": "boot", "display": "display", "assoc": "assoc", "ntp": "ntp",
+               "http": "http", "parse": "parse", "hibernate": "hibernate", "scan_full": "scan"}
+    for key, phase in mapping.items():
+        value = median(phase)
+        if value is not None:
+            durations[key] = value
+            measured[key] = value
+    # Renders over two seconds are full refreshes
+    for key, select in (("render_partial", lambda ms: 0 < ms <= 2000), ("render_full", lambda ms: ms > 2000)):
+        value = median("render", select)
+        if value is not None:
+            durations[key] = value
+            measured[key] = value
+    return measured
+
+
+class Device:
+    """State the firmware keeps in RTC memory, reduced to what costs energy."""
+
+    def __init__(self, config, durations, changes_per_day):
+        self.config = config
+        self.durations = durations
+        self.change_interval = 86400.0 / changes_per_day if changes_per_day > 0 else None
+        self.failed_wakes = 0
+        self.wakes_since_ntp = config.get("NTP_SYNC_EVERY_WAKES", 24)
+        self.wakes_since_attempt = 0
+        self.redraws = 0
+        self.offline_drawn = False
+        self.seen_version = -1
+        self.has_session = False
+        self.fetched_change = False
+        self.seconds_since_fetch = 0
+        self.drawn_day = None
+        self.timeouts = {}  # consecutive timeouts per phase
+
+    def local_updates(self):
+        return self.config.get("FETCH_INTERVAL", 0) > 0
+
+    def fetch_due(self):
+        goals = self.config.get("GOAL_COUNT", 1)
+        if goals <= 1 and not self.local_updates():
+            return True
+        self.wakes_since_attempt += 1
+        if self.failed_wakes > 0 or not self.local_updates():
+            every = 1 if goals <= 1 else self.config.get("FETCH_EVERY_WAKES", 4) << min(self.failed_wakes, 3)
+            due = self.wakes_since_attempt >= every
+        else:
+            due = self.seconds_since_fetch >= self.config["FETCH_INTERVAL"] // 1000
+        if due:
+            self.wakes_since_attempt = 0
+        return due
+
+    def timeout(self, name, fixed, learned):
+        """Length of a wait that runs out: learned from the normal latency,
+        the fixed timeout for a probe after a timeout."""
+        if not self.config.get("ADAPTIVE_TIMEOUTS"):
+            return fixed
+        count = self.timeouts.get(name, 0)
+        self.timeouts[name] = count % TIMEOUT_PROBE_EVERY + 1
+        return fixed if count == 1 else min(learned, fixed)
+
+    def wake(self, now, ap_up, api):
+        """Runs one wake, returns the list of (phase, ms)."""
+        c, d = self.config, self.durations
+        budget = c.get("WAKE_TIME_BUDGET", 30000)
+        phases = [("boot", d["boot"])]
+        spent = 0
+        fetched = False
+        redraw = c.get("GOAL_COUNT", 1) > 1  # every wake turns the page
+
+        if c.get("MOCK_MODE", False):
+            fetched = True
+        elif self.fetch_due():
+            if ap_up:
+                self.timeouts.pop("assoc", None)
+                phases.append(("assoc", d["assoc"]))
+                spent += d["assoc"]
+                self.wakes_since_ntp += 1
+                if self.wakes_since_ntp >= c.get("NTP_SYNC_EVERY_WAKES", 24):
+                    phases.append(("ntp", d["ntp"]))
+                    self.wakes_since_ntp = 0
+                if str(c.get("API_URL", "")).startswith("https://"):
+                    tls = d["tls_resumed"] if self.has_session else d["tls_full"]
+                    phases.append(("tls", tls))
+                    spent += tls
+                    self.has_session = True
+                if api == "hang":
+                    wait = self.timeout("http", d["http_timeout"], d["http_timeout_learned"])
+                    phases.append(("http", min(wait, max(0, budget - spent))))
+                else:
+                    self.timeouts.pop("http", None)
+                    if api == "ok":
+                        phases += [("http", d["http"]), ("parse", d["parse"])]
+                        fetched = True
+                    else:
+                        phases.append(("http", d["http_error"]))
+            else:
+                # Cached AP, then a scan of its channel, then a full scan
+                wait = self.timeout("assoc", c.get("WIFI_FAST_CONNECT_TIMEOUT", 5000), d["assoc_timeout_learned"])
+                cached = min(wait, budget)
+                phases += [("assoc", cached), ("scan", d["scan_channel"]), ("scan", d["scan_full"])]
+
+        if fetched:
+            self.failed_wakes = 0
+            self.seconds_since_fetch = 0
+            if self.offline_drawn:
+                redraw = True
+                self.offline_drawn = False
+            version = int(now // self.change_interval) if self.change_interval else 0
+            self.fetched_change = version != self.seen_version
+            if self.fetched_change:
+                redraw = True
+                self.seen_version = version
+        elif len(phases) > 1:
+            self.failed_wakes += 1
+            self.fetched_change = False
+            if self.failed_wakes >= c.get("OFFLINE_REDRAW_AFTER", 3) and not self.offline_drawn:
+                redraw = True
+                self.offline_drawn = True
+
+        # Local updates redraw when the days left tick down
+        day = local_day(now, c)
+        if self.local_updates() and day != self.drawn_day:
+            redraw = True
+        if redraw:
+            self.drawn_day = day
+            phases.append(("display", d["display"]))
+            full = not c.get("PARTIAL_REFRESH", True) or self.redraws % c.get("FULL_REFRESH_EVERY", 12) == 0
+            refresh = d["render_full"] if full else d["render_partial"]
+            if c.get("BUSY_LIGHT_SLEEP"):
+                phases.append(("render", min(d["draw"], refresh)))
+                phases.append(("busy_sleep", max(0, refresh - d["draw"])))
+            else:
+                phases.append(("render", refresh))
+            self.redraws += 1
+        phases.append(("hibernate", d["hibernate"]))
+        return phases
+
+    def sleep_seconds(self, now):
+        c = self.config
+        base = c.get("UPDATE_INTERVAL", 3600000) // 1000
+        longest = max(c.get("MAX_UPDATE_INTERVAL", 0) // 1000, base)
+        if c.get("GOAL_COUNT", 1) > 1:
+            seconds = base
+        elif self.local_updates() and self.failed_wakes == 0:
+            # Sleep until the next fetch, WakeScheduler::planSleep()
+            interval = c["FETCH_INTERVAL"] // 1000
+            seconds = max(interval - min(self.seconds_since_fetch, interval), base)
+        elif self.failed_wakes > 0:
+            # Retry at the base interval once, then double per failed wake
+            limit = max(c.get("MAX_BACKOFF_INTERVAL", 0) // 1000, base)
+            seconds = min(base << min(self.failed_wakes - 1, 16), limit)
+        elif c.get("ADAPTIVE_SCHEDULE", False) and not self.fetched_change and self.change_interval:
+            # Steady state of WakeScheduler::adaptiveInterval(): half the time between changes
+            seconds = int(min(max(self.change_interval / 2, base), longest))
+        else:
+            seconds = base
+        if self.local_updates():
+            # Wake just after midnight for the countdown
+            until_midnight = 86400 - (now + c.get("TIMEZONE_OFFSET", 0)) % 86400
+            seconds = min(seconds, int(until_midnight) + 120)
+        seconds = skip_quiet_hours(now, seconds, c)
+        self.seconds_since_fetch += seconds
+        return seconds
+
+
+def local_day(now, config):
+    return int((now + config.get("TIMEZONE_OFFSET", 0)) // 86400)
+
+
+def skip_quiet_hours(now, seconds, config):
+    start, end = config.get("QUIET_HOURS_START", 0), config.get("QUIET_HOURS_END", 0)
+    if start == end:
+        return seconds
+    local = (now + seconds + config.get("TIMEZONE_OFFSET", 0)) % 86400
+    hour = local // 3600
+    quiet = start <= hour < end if start < end else hour >= start or hour < end
+    if not quiet:
+        return seconds
+    return seconds + int((end * 3600 - local) % 86400)
+
+
+def simulate(days, config, durations, currents, changes_per_day):
+    """Per-day totals of wakes, radio wakes, redraws and mAh per phase."""
+    device = Device(config, durations, changes_per_day)
+    results = []
+    now = 0.0
+    for day, (condition, ap_up, api) in enumerate(days):
+        day_end = (day + 1) * 86400.0
+        charge = dict.fromkeys(list(currents), 0.0)  # mA*ms
+        wakes = radio = redraws = 0
+        awake_ms = 0
+        while now < day_end:
+            phases = device.wake(now, ap_up, api)
+            wakes += 1
+            radio += any(name in ("assoc", "scan") for name, _ in phases)
+            redraws += any(name == "render" for name, _ in phases)
+            wake_ms = sum(ms for name, ms in phases if name != "display")
+            awake_ms += wake_ms
+            for name, ms in phases:
+                charge[name] += currents[name] * ms
+            sleep = device.sleep_seconds(now + wake_ms / 1000.0)
+            charge["sleep"] += currents["sleep"] * sleep * 1000.0
+            now += wake_ms / 1000.0 + sleep
+        mah = {name: value / 3600000.0 for name, value in charge.items()}
+        results.append({"condition": condition, "wakes": wakes, "radio": radio,
+                        "redraws": redraws, "awake_s": awake_ms / 1000.0, "mah": mah})
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--config", default=find_config(), help="config.h to read (default include/config.h)")
+    parser.add_argument("--set", action="append", default=[], metavar="NAME=VALUE",
+                        help="override a config value, e.g. UPDATE_INTERVAL=1800000")
+    parser.add_argument("--profile", help="JSON file with phase currents (mA)")
+    parser.add_argument("--log", help="wake log to take phase durations from")
+    parser.add_argument("--capacity", type=float, default=1000, help="battery capacity (mAh)")
+    parser.add_argument("--usable", type=float, default=0.85, help="usable fraction of the capacity")
+    parser.add_argument("--changes-per-day", type=float, default=1, help="how often the API data changes")
+    parser.add_argument("--days", type=int, default=7, help="days simulated per steady scenario")
+    parser.add_argument("--scenario", choices=sorted(SCENARIOS), action="append",
+                        help="scenario(s) to run (default all)")
+    parser.add_argument("--breakdown", action="store_true", help="mAh/day per phase for each scenario")
+    args = parser.parse_args()
+
+    if not args.config:
+        sys.exit("no config.h found, pass --config")
+    config = read_config(args.config)
+    for assignment in args.set:
+        name, _, value = assignment.partition("=")
+        config[name] = parse_value(value)
+    resolve(config)
+
+    currents = dict(CURRENTS)
+    if args.profile:
+        with open(args.profile) as file:
+            currents.update(json.load(file))
+    durations = dict(DURATIONS)
+    if config.get("DEBUG_MODE"):
+        durations["boot"] += durations["console_wait"]
+    measured = {}
+    if args.log:
+        wakes = read_log(args.log)
+        if not wakes:
+            sys.exit("no wake records in %s" % args.log)
+        measured = apply_log(durations, wakes)
+        print("%d logged wakes, measured: %s" % (len(wakes),
+              ", ".join("%s=%d" % item for item in sorted(measured.items())) or "nothing"))
+
+    print("config %s: UPDATE_INTERVAL %s s, MOCK_MODE %s, DEBUG_MODE %s, BUSY_LIGHT_SLEEP %s, GOAL_COUNT %s, %s" % (
+        os.path.basename(args.config), config.get("UPDATE_INTERVAL", 0) // 1000,
+        config.get("MOCK_MODE"), config.get("DEBUG_MODE"), config.get("BUSY_LIGHT_SLEEP"),
+        config.get("GOAL_COUNT", 1),
+        "HTTPS" if str(config.get("API_URL", "")).startswith("https://") else "HTTP"))
+    print("battery %.0f mAh (%.0f%% usable), data changes %.1f/day\n" % (
+        args.capacity, args.usable * 100, args.changes_per_day))
+
+    print("%-12s %7s %7s %8s %9s %10s %9s %10s" % (
+        "scenario", "wakes/d", "radio/d", "redraw/d", "awake s/d", "mAh/day", "avg uA", "life days"))
+    for name in args.scenario or list(SCENARIOS):
+        days = SCENARIOS[name]
+        if len(days) == 1:
+            days = days * args.days
+        results = simulate(days, config, durations, currents, args.changes_per_day)
+        count = len(results)
+        mah_day = sum(sum(r["mah"].values()) for r in results) / count
+        print("%-12s %7.1f %7.1f %8.1f %9.1f %10.2f %9.0f %10.0f" % (
+            name,
+            sum(r["wakes"] for r in results) / count,
+            sum(r["radio"] for r in results) / count,
+            sum(r["redraws"] for r in results) / count,
+            sum(r["awake_s"] for r in results) / count,
+            mah_day, mah_day / 24 * 1000,
+            args.capacity * args.usable / mah_day))
+        if args.breakdown:
+            for phase in ["sleep"] + PHASES[:-1] + ["busy_sleep", "tls", "hibernate"]:
+                value = sum(r["mah"].get(phase, 0) for r in results) / count
+                if value > 0:
+                    print("    %-10s %8.3f mAh/day %5.1f%%" % (phase, value, value / mah_day * 100))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Builds the binary delta between two firmware images for OTA updates.
+
+    python3 tools/make_delta.py old.bin new.bin -o old-new.gtd
+    python3 tools/make_delta.py --apply old.bin old-new.gtd -o new.bin
+    python3 tools/make_delta.py old.bin new.bin -o old-new.gtd --sign ota-key.pem
+
+The images are the app .bin files PlatformIO builds
+(.pio/build/<env>/firmware.bin); keep the one of every released
+FIRMWARE_VERSION, a device can only patch the image it runs. The format is
+described in include/DeltaPatch.h: copies from the old image, each with a
+few replaced bytes (code that moved mostly differs in its addresses), and
+inserted new bytes. Every patch written is applied again here and compared
+with the new image. --apply is the same reference applier; the firmware's
+own patcher is checked with the native build:
+
+    .pio/build/native/program --delta old.bin old-new.gtd new.bin
+
+--sign prints the signature the device checks the new image against
+(OTA_PUBLIC_KEY): ECDSA P-256 over its SHA-256, DER as hex, made with the
+openssl command line tool. It goes in the "signature" of the offer.
+tools/mock_server.py --firmware builds the patches on demand.
+"""
+
+import argparse
+import struct
+import subprocess
+import sys
+import zlib
+
+MAGIC = b"GTD1"
+HEADER = struct.Struct("<4sIIII")
+
+# Bytes that have to match exactly to start a copy, and the spacing of the
+# indexed old image offsets (instructions are 2 or 4 bytes)
+BLOCK = 16
+STEP = 4
+# Scoring of a copy's extension: a replaced byte costs about as much as
+# three matching ones save; give up once the score falls this far behind
+MISMATCH_COST = 3
+GIVE_UP = 32
+# Equal bytes between two differences below which one edit covers both
+# (an edit costs 3 bytes)
+EDIT_GAP = 3
+
+
+def crc32(data):
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def find_ops(old, new):
+    """Copies ("C", source, length, edits) and inserts ("I", bytes)."""
+    index = {}
+    for offset in range(0, len(old) - BLOCK + 1, STEP):
+        index.setdefault(old[offset:offset + BLOCK], offset)
+
+    ops = []
+    literal = 0  # start of the new bytes not covered yet
+    position = 0
+    expected = None  # old offset continuing the last copy
+    while position <= len(new) - BLOCK:
+        block = new[position:position + BLOCK]
+        source = None
+        # Code after an insertion usually continues at the same distance
+        if expected is not None and old[expected:expected + BLOCK] == block:
+            source = expected
+        else:
+            source = index.get(block)
+        if source is None:
+            position += 1
+            if expected is not None:
+                expected += 1
+            continue
+
+        # Take back matching bytes from the pending insert
+        while position > literal and source > 0 and new[position - 1] == old[source - 1]:
+            position -= 1
+            source -= 1
+        length = extend(old, new, source, position)
+
+        if literal < position:
+            ops.append(("I", new[literal:position]))
+        ops.append(("C", source, length, edits(old[source:source + length], new[position:position + length])))
+        position += length
+        literal = position
+        expected = source + length
+
+    if literal < len(new):
+        ops.append(("I", new[literal:]))
+    return ops
+
+
+def extend(old, new, source, position):
+    """Length of the copy from source that pays off best."""
+    limit = min(len(old) - source, len(new) - position)
+    score = best = length = 0
+    for i in range(limit):
+        score += 1 if old[source + i] == new[position + i] else -MISMATCH_COST
+        if score > best:
+            best, length = score, i + 1
+        elif score < best - GIVE_UP:
+            break
+    return length
+
+
+def edits(old, new):
+    """(offset, bytes) runs where new differs from old."""
+    runs = []
+    i = 0
+    while i < len(new):
+        if old[i] == new[i]:
+            i += 1
+            continue
+        start = end = i
+        while i < len(new) and i - end <= EDIT_GAP:
+            if old[i] != new[i]:
+                end = i + 1
+            i += 1
+        runs.append((start, new[start:end]))
+        i = end
+    # An edit replaces at most 255 bytes
+    split = []
+    for start, data in runs:
+        for offset in range(0, len(data), 255):
+            split.append((start + offset, data[offset:offset + 255]))
+    return split
+
+
+def encode_copy(source, length, runs):
+    fields = []
+    end = 0
+    for offset, data in runs:
+        skip = offset - end
+        while skip > 0xFFFF:
+            fields.append(struct.pack("<HB", 0xFFFF, 0))
+            skip -= 0xFFFF
+        fields.append(struct.pack("<HB", skip, len(data)) + data)
+        end = offset + len(data)
+    if len(fields) > 0xFFFF:
+        # Too many edits for one copy, split it
+        half = len(runs) // 2
+        cut = runs[half][0]
+        rest = [(offset - cut, data) for offset, data in runs[half:]]
+        return encode_copy(source, cut, runs[:half]) + encode_copy(source + cut, length - cut, rest)
+    return b"C" + struct.pack("<IIH", source, length, len(fields)) + b"".join(fields)
+
+
+def make_patch(old, new):
+    parts = [HEADER.pack(MAGIC, len(old), crc32(old), len(new), crc32(new))]
+    for op in find_ops(old, new):
+        if op[0] == "C":
+            parts.append(encode_copy(*op[1:]))
+        else:
+            parts.append(b"I" + struct.pack("<I", len(op[1])) + op[1])
+    parts.append(b"E")
+    return b"".join(parts)
+
+
+def apply_patch(old, patch):
+    """Reference applier; raises ValueError on a bad patch."""
+    magic, old_size, old_crc, new_size, new_crc = HEADER.unpack_from(patch)
+    if magic != MAGIC:
+        raise ValueError("not a delta patch")
+    if old_size > len(old) or crc32(old[:old_size]) != old_crc:
+        raise ValueError("patch is for a different image")
+    out = bytearray()
+    position = HEADER.size
+    while True:
+        op = patch[position:position + 1]
+        position += 1
+        if op == b"C":
+            source, length, count = struct.unpack_from("<IIH", patch, position)
+            position += 10
+            if source + length > old_size:
+                raise ValueError("copy outside the old image")
+            copy = bytearray(old[source:source + length])
+            end = 0
+            for _ in range(count):
+                skip, size = struct.unpack_from("<HB", patch, position)
+                position += 3
+                start = end + skip
+                if start + size > length:
+                    raise ValueError("edit outside its copy")
+                copy[start:start + size] = patch[position:position + size]
+                position += size
+                end = start + size
+            out += copy
+        elif op == b"I":
+            (length,) = struct.unpack_from("<I", patch, position)
+            position += 4
+            out += patch[position:position + length]
+            position += length
+        elif op == b"E":
+            break
+        else:
+            raise ValueError("unknown patch operation")
+    if position != len(patch):
+        raise ValueError("data after the end of the patch")
+    if len(out) != new_size or crc32(out) != new_crc:
+        raise ValueError("new image CRC mismatch")
+    return bytes(out)
+
+
+def sign_image(image, key):
+    """Signature of an image for OTA_PUBLIC_KEY, as hex."""
+    result = subprocess.run(["openssl", "dgst", "-sha256", "-sign", key], input=image,
+                            stdout=subprocess.PIPE, check=True)
+    return result.stdout.hex()
+
+
+def describe(old, new, patch):
+    return "%d byte patch for a %d byte image (%.1f%%), base %d bytes" % (
+        len(patch), len(new), 100.0 * len(patch) / max(1, len(new)), len(old))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old", help="image the device runs")
+    parser.add_argument("new", help="new image, or the patch with --apply")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--apply", action="store_true", help="apply a patch instead of making one")
+    parser.add_argument("--sign", metavar="KEY", help="print the new image's signature by this PEM key")
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as file:
+        old = file.read()
+    with open(args.new, "rb") as file:
+        second = file.read()
+
+    try:
+        if args.apply:
+            result = apply_patch(old, second)
+        else:
+            result = make_patch(old, second)
+            if apply_patch(old, result) != second:
+                raise ValueError("patch does not reproduce the new image")
+            print(describe(old, second, result))
+            if args.sign:
+                print("signature: %s" % sign_image(second, args.sign))
+    except ValueError as error:
+        sys.exit("%s: %s" % (args.new, error))
+
+    with open(args.output, "wb") as file:
+        file.write(result)
+
+
+if __name__ == "__main__":
+    main()
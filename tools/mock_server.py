@@ -0,0 +1,425 @@
+#!/usr/bin/env python3
+"""Local stand-in for the portfolio summary API.
+
+Serves the same JSON shape as the real endpoint so a device (or curl) can be
+pointed at it during development:
+
+    python3 tools/mock_server.py --port 4000 --token YOUR_API_TOKEN
+
+and in include/config.h:
+
+    API_URL = "http://<this machine's IP>:4000/api/portfolio/summary"
+
+Supports conditional requests (ETag / Last-Modified, answered with 304) and
+prints the wake-cycle timings a device attaches in the X-Wake-Profile header
+and the log records in X-Device-Log.
+--max-age adds a Cache-Control hint for the device's wake scheduler.
+--goals N serves the batched format for GOAL_COUNT > 1 ({"goals": [...]},
+N goals with a "name" each).
+Clients sending "Accept: application/msgpack" get the same document as
+MessagePack; --json-only turns that off to test the device's JSON fallback.
+--tls-cert/--tls-key serve HTTPS (https:// in API_URL). The certificate pin
+for API_CERT_SHA256 is printed at startup, and each request logs whether the
+TLS session was resumed. A self-signed certificate for testing:
+
+    openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes \
+        -days 365 -subj /CN=goal-tracker -keyout key.pem -out cert.pem
+--firmware DIR offers OTA updates: DIR holds one <FIRMWARE_VERSION>.bin per
+release, and a device reporting an older version (X-Firmware-Version) gets a
+"firmware" object pointing at /firmware/<its version>/<newest>.gtd, a patch
+built with tools/make_delta.py on first request. --signing-key KEY signs the
+offered image for the device's OTA_PUBLIC_KEY (the device ignores unsigned
+offers and only updates over HTTPS).
+POST /control with a JSON body updates the served values, e.g.
+
+    curl -X POST localhost:4000/control -d '{"days_to_target": 3749}'
+
+Fault injection, to check the device's adaptive timeouts: --latency/--jitter
+delay every answer (ms), --stall P leaves a request unanswered with
+probability P (the connection is dropped after --stall-seconds), and
+--truncate P cuts a body in half after a full Content-Length. POST /faults
+changes them while the server runs, e.g. a network that got slower:
+
+    curl -X POST localhost:4000/faults -d '{"latency": 3000, "jitter": 500}'
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import random
+import re
+import ssl
+import struct
+import time
+from datetime import datetime, timezone
+from email.utils import format_datetime, parsedate_to_datetime
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+from make_delta import describe, make_patch, sign_image
+
+API_PATH = "/api/portfolio/summary"
+PHASES = ["boot", "display", "scan", "assoc", "ntp", "http", "parse", "render", "hibernate"]
+
+
+def print_wake_profile(header):
+    version, _, records = header.partition(";")
+    if version != "1" or not records:
+        return
+    for record in records.split("|"):
+        reset, wake, rssi, heap, phases = record.split(",")
+        timings = " ".join("%s=%s" % pair for pair in zip(PHASES, phases.split(".")))
+        print("  wake: reset=%s cause=%s rssi=%s minheap=%sk %s" % (reset, wake, rssi, heap, timings))
+
+
+def print_device_log(header):
+    # Records are "<level letter><unix time> <message>", oldest first
+    for record in header.split("|"):
+        stamp, _, message = record.partition(" ")
+        try:
+            when = datetime.fromtimestamp(int(stamp[1:]), timezone.utc).strftime("%Y-%m-%d %H:%M:%S")
+        except ValueError:
+            when = stamp[1:]
+        print("  log: %s %s %s" % (stamp[:1], when, message))
+
+
+def msgpack(value):
+    """Encodes the JSON types used here as MessagePack (no dependency needed)."""
+    if value is None:
+        return b"\xc0"
+    if value is True or value is False:
+        return b"\xc3" if value else b"\xc2"
+    if isinstance(value, int):
+        if 0 <= value < 0x80:
+            return struct.pack("B", value)
+        if -32 <= value < 0:
+            return struct.pack("b", value)
+        return b"\xd3" + struct.pack(">q", value)
+    if isinstance(value, float):
+        if struct.unpack(">f", struct.pack(">f", value))[0] == value:
+            return b"\xca" + struct.pack(">f", value)
+        return b"\xcb" + struct.pack(">d", value)
+    if isinstance(value, str):
+        data = value.encode()
+        if len(data) < 32:
+            return struct.pack("B", 0xA0 | len(data)) + data
+        return b"\xda" + struct.pack(">H", len(data)) + data
+    if isinstance(value, list):
+        head = struct.pack("B", 0x90 | len(value)) if len(value) < 16 else b"\xdc" + struct.pack(">H", len(value))
+        return head + b"".join(msgpack(item) for item in value)
+    if isinstance(value, dict):
+        head = struct.pack("B", 0x80 | len(value)) if len(value) < 16 else b"\xde" + struct.pack(">H", len(value))
+        return head + b"".join(msgpack(key) + msgpack(item) for key, item in value.items())
+    raise TypeError("cannot encode %r" % (value,))
+
+
+def certificate_pin(path):
+    """SHA-256 of the (first) certificate in a PEM file, as API_CERT_SHA256."""
+    with open(path) as file:
+        pem = re.search(r"-----BEGIN CERTIFICATE-----.+?-----END CERTIFICATE-----", file.read(), re.S)
+    digest = hashlib.sha256(ssl.PEM_cert_to_DER_cert(pem.group(0))).hexdigest().upper()
+    return ":".join(digest[i:i + 2] for i in range(0, len(digest), 2))
+
+
+def version_key(version):
+    return [int(part) if part.isdigit() else part for part in re.split(r"[.-]", version)]
+
+
+class Firmware:
+    """Release images in a directory, patches between them built on demand."""
+
+    def __init__(self, directory, key=None):
+        self.directory = directory
+        self.key = key
+        self.patches = {}
+        self.signatures = {}
+
+    def versions(self):
+        names = [name[:-4] for name in os.listdir(self.directory) if name.endswith(".bin")]
+        return sorted(names, key=version_key)
+
+    def offer(self, running):
+        versions = self.versions()
+        if not running or not versions or running == versions[-1] or running not in versions:
+            return None
+        offer = {"version": versions[-1], "url": "/firmware/%s/%s.gtd" % (running, versions[-1])}
+        if self.key:
+            offer["signature"] = self.signature(versions[-1])
+        return offer
+
+    def signature(self, version):
+        if version not in self.signatures:
+            with open(os.path.join(self.directory, version + ".bin"), "rb") as file:
+                self.signatures[version] = sign_image(file.read(), self.key)
+        return self.signatures[version]
+
+    def patch(self, old, new):
+        if (old, new) not in self.patches:
+            images = []
+            for version in (old, new):
+                path = os.path.join(self.directory, os.path.basename(version) + ".bin")
+                if not os.path.isfile(path):
+                    return None
+                with open(path, "rb") as file:
+                    images.append(file.read())
+            patch = make_patch(*images)
+            print("  patch %s -> %s: %s" % (old, new, describe(images[0], images[1], patch)))
+            self.patches[(old, new)] = patch
+        return self.patches[(old, new)]
+
+
+GOAL_NAMES = ["RETIREMENT", "HOUSE", "EMERGENCY", "CAR", "TRAVEL", "EDUCATION", "WEDDING", "BUFFER"]
+
+
+class Faults:
+    """Injected network faults: answer latency, stalled requests, cut bodies."""
+
+    def __init__(self, latency=0, jitter=0, stall=0.0, stall_seconds=120, truncate=0.0, seed=None):
+        self.values = {"latency": latency, "jitter": jitter, "stall": stall,
+                       "stall_seconds": stall_seconds, "truncate": truncate}
+        self.random = random.Random(seed)
+
+    def update(self, values):
+        unknown = set(values) - set(self.values)
+        if unknown:
+            raise ValueError("unknown fault(s): %s" % ", ".join(sorted(unknown)))
+        self.values.update(values)
+
+    def delay(self):
+        """Seconds to wait before answering."""
+        jitter = self.values["jitter"]
+        ms = self.values["latency"] + (self.random.uniform(-jitter, jitter) if jitter else 0)
+        return max(0, ms) / 1000.0
+
+    def stalls(self):
+        return self.random.random() < self.values["stall"]
+
+    def truncates(self):
+        return self.random.random() < self.values["truncate"]
+
+
+class State:
+    def __init__(self, goals=0):
+        self.goals = goals
+        self.values = {
+            "current_progress_percent": 22.2,
+            "days_to_target": 3750,
+        }
+        self.touch()
+
+    def touch(self):
+        # HTTP dates have one second resolution
+        self.modified = datetime.now(timezone.utc).replace(microsecond=0)
+
+    def goal(self, index):
+        # Further goals are derived from the controlled values
+        progress = self.values["current_progress_percent"]
+        return {
+            "goal_tracking": {
+                "current_progress_percent": round(min(100.0, progress + 15.0 * index), 1),
+            },
+            "projection": {
+                "days_to_target": max(0, self.values["days_to_target"] - 700 * index),
+            },
+            "metadata": {
+                "data_timestamp": self.modified.strftime("%Y-%m-%dT%H:%M:%S.000Z"),
+            },
+        }
+
+    def payload(self, firmware=None):
+        if self.goals:
+            goals = []
+            for index in range(self.goals):
+                goal = {"name": GOAL_NAMES[index % len(GOAL_NAMES)]}
+                goal.update(self.goal(index))
+                goals.append(goal)
+            payload = {"goals": goals}
+        else:
+            payload = self.goal(0)
+        if firmware:
+            payload["firmware"] = firmware
+        return payload
+
+    def body(self, packed=False, firmware=None):
+        if packed:
+            return msgpack(self.payload(firmware))
+        return json.dumps(self.payload(firmware)).encode()
+
+    def etag(self, packed=False, firmware=None):
+        # Each representation has its own tag
+        return '"%s"' % hashlib.sha1(self.body(packed, firmware)).hexdigest()[:16]
+
+
+class Handler(BaseHTTPRequestHandler):
+    state = None
+    token = None
+    max_age = None
+    json_only = False
+    firmware = None
+    faults = Faults()
+
+    def do_GET(self):
+        patch = re.match(r"^/firmware/([^/]+)/([^/]+)\.gtd$", self.path)
+        if self.path != API_PATH and not (patch and self.firmware):
+            self.send_error(404)
+            return
+        if self.token and self.headers.get("Authorization") != "Bearer " + self.token:
+            self.send_error(401)
+            return
+        if not self.inject_faults():
+            return
+        if patch:
+            self.send_patch(*patch.groups())
+            return
+
+        if isinstance(self.connection, ssl.SSLSocket):
+            print("  tls: %s, %s" % (self.connection.version(),
+                                     "resumed" if self.connection.session_reused else "full handshake"))
+
+        profile = self.headers.get("X-Wake-Profile")
+        if profile:
+            print_wake_profile(profile)
+        device_log = self.headers.get("X-Device-Log")
+        if device_log:
+            print_device_log(device_log)
+
+        state = self.state
+        packed = not self.json_only and "application/msgpack" in self.headers.get("Accept", "")
+        firmware = None
+        if self.firmware:
+            firmware = self.firmware.offer(self.headers.get("X-Firmware-Version"))
+            if firmware:
+                print("  firmware: %s offered to %s" % (firmware["version"],
+                                                        self.headers.get("X-Firmware-Version")))
+        etag = state.etag(packed, firmware)
+        last_modified = format_datetime(state.modified, usegmt=True)
+
+        if self.not_modified(etag, state.modified):
+            self.send_response(304)
+            self.send_header("ETag", etag)
+            self.send_header("Last-Modified", last_modified)
+            self.send_header("Vary", "Accept")
+            self.send_cache_control()
+            self.end_headers()
+            return
+
+        body = state.body(packed, firmware)
+        print("  body: %d bytes of %s" % (len(body), "MessagePack" if packed else "JSON"))
+        self.send_response(200)
+        self.send_header("Content-Type", "application/msgpack" if packed else "application/json")
+        self.send_header("Vary", "Accept")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("ETag", etag)
+        self.send_header("Last-Modified", last_modified)
+        self.send_cache_control()
+        self.end_headers()
+        self.write_body(body)
+
+    def inject_faults(self):
+        """Waits the injected latency; False if the request stalls instead."""
+        time.sleep(self.faults.delay())
+        if self.faults.stalls():
+            seconds = self.faults.values["stall_seconds"]
+            print("  fault: stalled, dropping the connection in %d s" % seconds)
+            time.sleep(seconds)
+            self.close_connection = True
+            return False
+        return True
+
+    def write_body(self, body):
+        if self.faults.truncates():
+            print("  fault: body cut at %d of %d bytes" % (len(body) // 2, len(body)))
+            self.wfile.write(body[:len(body) // 2])
+            self.close_connection = True
+            return
+        self.wfile.write(body)
+
+    def send_patch(self, old, new):
+        body = self.firmware.patch(old, new)
+        if body is None:
+            self.send_error(404)
+            return
+        self.send_response(200)
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.write_body(body)
+
+    def do_POST(self):
+        if self.path not in ("/control", "/faults"):
+            self.send_error(404)
+            return
+        length = int(self.headers.get("Content-Length", 0))
+        update = json.loads(self.rfile.read(length) or b"{}")
+        if self.path == "/faults":
+            try:
+                self.faults.update(update)
+            except ValueError as error:
+                self.send_error(400, str(error))
+                return
+            print("  faults: %s" % ", ".join("%s=%s" % item for item in sorted(self.faults.values.items())))
+        else:
+            self.state.values.update(update)
+            self.state.touch()
+        self.send_response(204)
+        self.end_headers()
+
+    def send_cache_control(self):
+        if self.max_age is not None:
+            self.send_header("Cache-Control", "max-age=%d" % self.max_age)
+
+    def not_modified(self, etag, modified):
+        if_none_match = self.headers.get("If-None-Match")
+        if if_none_match is not None:
+            return etag in [tag.strip() for tag in if_none_match.split(",")]
+        if_modified_since = self.headers.get("If-Modified-Since")
+        if if_modified_since:
+            try:
+                return modified <= parsedate_to_datetime(if_modified_since)
+            except (TypeError, ValueError):
+                return False
+        return False
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=4000)
+    parser.add_argument("--token", help="expected bearer token (any token accepted if omitted)")
+    parser.add_argument("--max-age", type=int, help="send Cache-Control: max-age=N (seconds)")
+    parser.add_argument("--goals", type=int, default=0, help="serve N goals in the batched format")
+    parser.add_argument("--json-only", action="store_true", help="ignore Accept: application/msgpack")
+    parser.add_argument("--firmware", help="directory of <version>.bin images to offer as OTA updates")
+    parser.add_argument("--signing-key", help="PEM key to sign the offered images with")
+    parser.add_argument("--tls-cert", help="serve HTTPS with this PEM certificate")
+    parser.add_argument("--tls-key", help="private key of --tls-cert (if not in the same file)")
+    parser.add_argument("--latency", type=int, default=0, help="delay every answer by MS")
+    parser.add_argument("--jitter", type=int, default=0, help="vary the delay by up to +-MS")
+    parser.add_argument("--stall", type=float, default=0.0, help="probability of never answering")
+    parser.add_argument("--stall-seconds", type=int, default=120, help="drop a stalled request after S")
+    parser.add_argument("--truncate", type=float, default=0.0, help="probability of cutting a body short")
+    parser.add_argument("--seed", type=int, help="random seed of the faults, for repeatable runs")
+    args = parser.parse_args()
+
+    Handler.state = State(args.goals)
+    Handler.token = args.token
+    Handler.max_age = args.max_age
+    Handler.json_only = args.json_only
+    Handler.faults = Faults(args.latency, args.jitter, args.stall, args.stall_seconds,
+                            args.truncate, args.seed)
+    if args.firmware:
+        Handler.firmware = Firmware(args.firmware, args.signing_key)
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    scheme = "http"
+    if args.tls_cert:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.tls_cert, args.tls_key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+        scheme = "https"
+        print("Certificate pin (API_CERT_SHA256): %s" % certificate_pin(args.tls_cert))
+    print("Serving %s on %s://%s:%d" % (API_PATH, scheme, args.host, args.port))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
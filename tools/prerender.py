@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Pre-rasterizes the fixed text of the goal screen at build time.
+
+Reads the Adafruit GFX font headers (FreeMonoBold12pt7b / 24pt7b) and writes
+Prerendered.h with byte-aligned 1-bpp bitmaps that GoalRenderer blits with
+drawBitmap instead of decoding glyphs on every frame:
+
+  - the static labels ("DAYS TO GOAL", "DAYS LEFT", "COMPLETE")
+  - an atlas of the 24pt characters used by the numbers ("0"-"9", ".", "%")
+
+Labels are drawn unrotated in screen coordinates, so one set of bitmaps
+serves every DISPLAY_ROTATION; only their placement differs.
+
+Runs as a PlatformIO pre-build script (extra_scripts in platformio.ini): the
+header goes to the build directory and GOAL_PRERENDERED is defined. If the
+fonts can't be found the build continues with the plain font path. It can
+also be run by hand:
+
+    python3 tools/prerender.py --fonts <Adafruit GFX Library>/Fonts --out Prerendered.h
+"""
+
+import argparse
+import os
+import re
+import sys
+
+LABELS = [
+    ("LABEL_DAYS_TO_GOAL", "FreeMonoBold12pt7b", "DAYS TO GOAL"),
+    ("LABEL_DAYS_LEFT", "FreeMonoBold12pt7b", "DAYS LEFT"),
+    ("LABEL_COMPLETE", "FreeMonoBold12pt7b", "COMPLETE"),
+]
+ATLAS_FONT = "FreeMonoBold24pt7b"
+ATLAS_CHARS = "0123456789.%"
+
+
+class Font:
+    def __init__(self, path):
+        with open(path) as f:
+            text = f.read()
+        bitmaps = re.search(r"const uint8_t \w+Bitmaps\[\]\s*(?:PROGMEM)?\s*=\s*\{(.*?)\};", text, re.S)
+        glyphs = re.search(r"const GFXglyph \w+Glyphs\[\]\s*(?:PROGMEM)?\s*=\s*\{(.*)\};\s*const GFXfont", text, re.S)
+        font = re.search(r"const GFXfont \w+\s*(?:PROGMEM)?\s*=\s*\{.*?,.*?,\s*(0x[0-9A-Fa-f]+),\s*(0x[0-9A-Fa-f]+),\s*(\d+)\s*\}",
+                         text, re.S)
+        if not (bitmaps and glyphs and font):
+            raise ValueError("not an Adafruit GFX font header: %s" % path)
+        self.bitmap = [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]+", bitmaps.group(1))]
+        self.glyphs = [tuple(int(v) for v in g) for g in
+                       re.findall(r"\{\s*(\d+),\s*(\d+),\s*(\d+),\s*(\d+),\s*(-?\d+),\s*(-?\d+)\s*\}",
+                                  glyphs.group(1))]
+        self.first = int(font.group(1), 16)
+        self.last = int(font.group(2), 16)
+
+    def glyph(self, char):
+        code = ord(char)
+        if not self.first <= code <= self.last:
+            raise ValueError("character %r not in font" % char)
+        return self.glyphs[code - self.first]
+
+    def render(self, text):
+        """Set pixels of `text` drawn at cursor (0, 0), like Adafruit_GFX::write."""
+        pixels = set()
+        cursor = 0
+        for char in text:
+            offset, width, height, advance, x_offset, y_offset = self.glyph(char)
+            bit = 0
+            for yy in range(height):
+                for xx in range(width):
+                    byte = self.bitmap[offset + bit // 8]
+                    if byte & (0x80 >> (bit % 8)):
+                        pixels.add((cursor + x_offset + xx, y_offset + yy))
+                    bit += 1
+            cursor += advance
+        return pixels, cursor
+
+
+def pack(name, pixels, advance):
+    """Byte-aligned rows, MSB first (the drawBitmap format)."""
+    if pixels:
+        left = min(x for x, _ in pixels)
+        top = min(y for _, y in pixels)
+        width = max(x for x, _ in pixels) - left + 1
+        height = max(y for _, y in pixels) - top + 1
+    else:
+        left = top = width = height = 0
+    row_bytes = (width + 7) // 8
+    data = bytearray(row_bytes * height)
+    for x, y in pixels:
+        x -= left
+        y -= top
+        data[y * row_bytes + x // 8] |= 0x80 >> (x % 8)
+    return {"name": name, "dx": left, "dy": top, "width": width, "height": height,
+            "advance": advance, "data": data}
+
+
+def emit_bits(out, bitmap):
+    out.append("static const uint8_t %s_BITS[] PROGMEM = {" % bitmap["name"])
+    data = bitmap["data"] or bytearray([0])
+    for i in range(0, len(data), 16):
+        out.append("    " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    out.append("};")
+
+
+def entry(bitmap):
+    return "{%d, %d, %d, %d, %d, %s_BITS}" % (bitmap["dx"], bitmap["dy"], bitmap["width"],
+                                             bitmap["height"], bitmap["advance"], bitmap["name"])
+
+
+def generate(fonts_dir):
+    fonts = {}
+
+    def font(name):
+        if name not in fonts:
+            fonts[name] = Font(os.path.join(fonts_dir, name + ".h"))
+        return fonts[name]
+
+    labels = [pack(name, *font(font_name).render(text)) for name, font_name, text in LABELS]
+    atlas = []
+    for i, char in enumerate(ATLAS_CHARS):
+        atlas.append(pack("ATLAS_%d" % i, *font(ATLAS_FONT).render(char)))
+
+    out = [
+        "// Generated by tools/prerender.py from the Adafruit GFX fonts - do not edit",
+        "#ifndef PRERENDERED_H",
+        "#define PRERENDERED_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "// Bitmap drawn with its top left corner at (cursor x + dx, baseline + dy);",
+        "// advance moves the cursor like the font would",
+        "struct PrerenderedBitmap {",
+        "    int16_t dx, dy;",
+        "    uint16_t width, height;",
+        "    int16_t advance;",
+        "    const uint8_t* bits;",
+        "};",
+        "",
+    ]
+    for bitmap in labels + atlas:
+        emit_bits(out, bitmap)
+    out.append("")
+    for bitmap in labels:
+        out.append("static const PrerenderedBitmap %s = %s;" % (bitmap["name"], entry(bitmap)))
+    out.append("")
+    out.append("// %s characters \"%s\"" % (ATLAS_FONT, ATLAS_CHARS))
+    out.append("static const char ATLAS_CHARS[] = \"%s\";" % ATLAS_CHARS)
+    out.append("static const PrerenderedBitmap ATLAS_GLYPHS[] = {")
+    for bitmap in atlas:
+        out.append("    %s," % entry(bitmap))
+    out.append("};")
+    out.append("")
+    out.append("#endif // PRERENDERED_H")
+    return "\n".join(out) + "\n"
+
+
+def write_if_changed(path, text):
+    # Leave the file alone when nothing changed so it doesn't trigger rebuilds
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def run_from_platformio(env):
+    fonts_dir = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"),
+                             "Adafruit GFX Library", "Fonts")
+    out_dir = os.path.join(env.subst("$BUILD_DIR"), "generated")
+    try:
+        text = generate(fonts_dir)
+    except (OSError, ValueError) as error:
+        print("prerender: %s, using the font renderer" % error)
+        return
+    write_if_changed(os.path.join(out_dir, "Prerendered.h"), text)
+    env.Append(CPPPATH=[out_dir], CPPDEFINES=["GOAL_PRERENDERED"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--fonts", required=True, help="Fonts directory of the Adafruit GFX library")
+    parser.add_argument("--out", required=True, help="header to write")
+    args = parser.parse_args()
+    try:
+        write_if_changed(args.out, generate(args.fonts))
+    except (OSError, ValueError) as error:
+        sys.exit("prerender: %s" % error)
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    run_from_platformio(env)  # noqa: F821